@@ -1,2 +1,2 @@
 include src/m6rc/Makefile.mk
-
+include src/pyext/Makefile.mk
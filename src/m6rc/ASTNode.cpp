@@ -5,6 +5,7 @@
 ASTNode::ASTNode(const Token& token) :
         tokenType_(token.type),
         value_(token.value),
+        filename_(token.filename),
         line_(token.line),
         column_(token.column),
         parentNode_(NULL) {
@@ -22,5 +23,9 @@ auto ASTNode::printTree(int level) const -> void {
     for (const auto& child : childNodes_) {
         child->printTree(level + 1);
     }
+
+    if (fragment_) {
+        fragment_->printTree(level + 1);
+    }
 }
 
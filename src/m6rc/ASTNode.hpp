@@ -3,6 +3,7 @@
 
 #include <string>
 #include <vector>
+#include <memory>
 
 #include "Token.hpp"
 
@@ -10,10 +11,13 @@ class ASTNode {
 public:
     TokenType tokenType_;
     std::string value_;
+    std::shared_ptr<const std::string> filename_;
     int line_;
     int column_;
     ASTNode* parentNode_;
     std::vector<std::unique_ptr<ASTNode>> childNodes_;
+    std::shared_ptr<ASTNode> fragment_; // For INCLUDE nodes, the subtree parsed from the included file.  This is
+                                        // shared between every place the same file is included.
 
     ASTNode(const Token& token);
     auto addChild(std::unique_ptr<ASTNode> child) -> void;
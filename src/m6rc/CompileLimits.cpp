@@ -0,0 +1,69 @@
+#include "CompileLimits.hpp"
+
+LimitExceededError::LimitExceededError(const std::string& message) :
+        std::runtime_error(message) {
+}
+
+CompileLimits::CompileLimits() :
+        maxInputBytes_(0),
+        maxFileBytes_(0),
+        maxIncludeDepth_(0),
+        maxFiles_(0),
+        maxOutputBytes_(0),
+        timeLimit_(0),
+        deadline_(std::chrono::steady_clock::time_point::max()) {
+}
+
+// Start timing the compilation.  Until this is called there is no deadline.
+auto CompileLimits::startClock() -> void {
+    if (timeLimit_.count() == 0) {
+        deadline_ = std::chrono::steady_clock::time_point::max();
+        return;
+    }
+
+    deadline_ = std::chrono::steady_clock::now() + timeLimit_;
+}
+
+auto CompileLimits::checkDeadline() const -> void {
+    if (deadline_ == std::chrono::steady_clock::time_point::max()) {
+        return;
+    }
+
+    if (std::chrono::steady_clock::now() > deadline_) {
+        throw LimitExceededError("Compilation exceeded the time limit of " + std::to_string(timeLimit_.count()) +
+                " ms");
+    }
+}
+
+auto CompileLimits::checkFileSize(const std::string& filename, size_t fileBytes) const -> void {
+    if (maxFileBytes_ && fileBytes > maxFileBytes_) {
+        throw LimitExceededError("'" + filename + "' is " + std::to_string(fileBytes) +
+                " bytes, which exceeds the file size limit of " + std::to_string(maxFileBytes_) + " bytes");
+    }
+}
+
+auto CompileLimits::checkInputBytes(size_t totalBytes) const -> void {
+    if (maxInputBytes_ && totalBytes > maxInputBytes_) {
+        throw LimitExceededError("Input exceeds the total size limit of " + std::to_string(maxInputBytes_) +
+                " bytes");
+    }
+}
+
+auto CompileLimits::checkFileCount(size_t files) const -> void {
+    if (maxFiles_ && files > maxFiles_) {
+        throw LimitExceededError("Input exceeds the limit of " + std::to_string(maxFiles_) + " files");
+    }
+}
+
+auto CompileLimits::checkIncludeDepth(const std::string& filename, size_t depth) const -> void {
+    if (maxIncludeDepth_ && depth > maxIncludeDepth_) {
+        throw LimitExceededError("Including '" + filename + "' exceeds the include depth limit of " +
+                std::to_string(maxIncludeDepth_));
+    }
+}
+
+auto CompileLimits::checkOutputBytes(size_t totalBytes) const -> void {
+    if (maxOutputBytes_ && totalBytes > maxOutputBytes_) {
+        throw LimitExceededError("Output exceeds the size limit of " + std::to_string(maxOutputBytes_) + " bytes");
+    }
+}
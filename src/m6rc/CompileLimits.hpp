@@ -0,0 +1,40 @@
+#ifndef __COMPILELIMITS_HPP
+#define __COMPILELIMITS_HPP
+
+#include <string>
+#include <chrono>
+#include <stdexcept>
+
+// Thrown when compilation is stopped because it has exceeded one of its resource limits.
+class LimitExceededError : public std::runtime_error {
+public:
+    LimitExceededError(const std::string& message);
+};
+
+// Resource budgets for a single compilation.  A limit of zero means there is no limit.
+class CompileLimits {
+public:
+    CompileLimits();
+
+    auto startClock() -> void;
+    auto checkDeadline() const -> void;
+    auto checkFileSize(const std::string& filename, size_t fileBytes) const -> void;
+    auto checkInputBytes(size_t totalBytes) const -> void;
+    auto checkFileCount(size_t files) const -> void;
+    auto checkIncludeDepth(const std::string& filename, size_t depth) const -> void;
+    auto checkOutputBytes(size_t totalBytes) const -> void;
+
+    size_t maxInputBytes_;              // Maximum number of bytes read from all files
+    size_t maxFileBytes_;               // Maximum size of any one file
+    size_t maxIncludeDepth_;            // Maximum depth of nested Includes
+    size_t maxFiles_;                   // Maximum number of distinct files read
+    size_t maxOutputBytes_;             // Maximum number of bytes of prompt output
+    std::chrono::milliseconds timeLimit_;
+                                        // Maximum wall clock time for the compilation
+
+private:
+    std::chrono::steady_clock::time_point deadline_;
+                                        // Time at which compilation must be abandoned
+};
+
+#endif // __COMPILELIMITS_HPP
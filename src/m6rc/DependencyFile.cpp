@@ -0,0 +1,46 @@
+#include "DependencyFile.hpp"
+
+// Escape a filename so make treats it as a single word.
+static auto escapeMakeFilename(const std::string& filename) -> std::string {
+    std::string escaped;
+    escaped.reserve(filename.size());
+
+    for (char ch : filename) {
+        switch (ch) {
+        case ' ':
+        case '\t':
+        case '#':
+            escaped += '\\';
+            break;
+
+        case '$':
+            escaped += '$';
+            break;
+
+        default:
+            break;
+        }
+
+        escaped += ch;
+    }
+
+    return escaped;
+}
+
+auto writeDependencyFile(std::ostream& out, const std::string& target, const std::vector<std::string>& dependencies,
+        bool phonyTargets) -> void {
+    out << escapeMakeFilename(target) << ":";
+    for (const auto& dependency : dependencies) {
+        out << " \\\n  " << escapeMakeFilename(dependency);
+    }
+
+    out << "\n";
+
+    if (!phonyTargets) {
+        return;
+    }
+
+    for (size_t i = 1; i < dependencies.size(); i++) {
+        out << "\n" << escapeMakeFilename(dependencies[i]) << ":\n";
+    }
+}
@@ -0,0 +1,14 @@
+#ifndef __DEPENDENCYFILE_HPP
+#define __DEPENDENCYFILE_HPP
+
+#include <string>
+#include <vector>
+#include <ostream>
+
+// Writes a make-compatible dependency rule, in the same form as "g++ -MD", stating that target depends on
+// every file in dependencies.  The first dependency is taken to be the root file.  If phonyTargets is set then
+// an empty rule is also written for every other dependency so make doesn't fail if one of them is removed.
+auto writeDependencyFile(std::ostream& out, const std::string& target, const std::vector<std::string>& dependencies,
+        bool phonyTargets) -> void;
+
+#endif // __DEPENDENCYFILE_HPP
@@ -1,20 +1,37 @@
+#include <algorithm>
 #include <iostream>
 #include <fstream>
 #include <unordered_map>
 
 #include "EmbedLexer.hpp"
 
-EmbedLexer::EmbedLexer(const std::string& filename) :
-        Lexer(filename) {
+EmbedLexer::EmbedLexer(const std::string& filename, std::string input, MinifyMode minifyMode, TokenRing* ring,
+        const CompileLimits* limits) :
+        Lexer(filename, minifyInput(filename, std::move(input), minifyMode), ring, limits) {
     lexTokens();
 }
 
+// Lexes input that is already in its final form, without taking a copy of it.
+EmbedLexer::EmbedLexer(const std::string& filename, std::string_view input, const CompileLimits* limits) :
+        Lexer(filename, input, nullptr, limits) {
+    lexTokens();
+}
+
+// Minification has to happen before the base class starts lexing, and works in place on the input.
+auto EmbedLexer::minifyInput(const std::string& filename, std::string input, MinifyMode minifyMode) -> std::string {
+    if (minifyMode != MinifyMode::NONE) {
+        Minifier(getLanguageFromFilename(filename)).minify(input, minifyMode);
+    }
+
+    return input;
+}
+
 auto EmbedLexer::readText() -> Token {
     position_ = endOfLine_;
     return Token(TokenType::TEXT, line_.substr(0, endOfLine_ - startOfLine_), line_, filename_, currentLine_, 1);
 }
 
-auto EmbedLexer::getLanguageFromFilename() -> std::string {
+auto EmbedLexer::getLanguageFromFilename(const std::string& filename) -> std::string {
     static const std::unordered_map<std::string, std::string> extensionToLanguage = {
         {".bash", "bash"},
         {".c", "c"},
@@ -60,7 +77,12 @@ auto EmbedLexer::getLanguageFromFilename() -> std::string {
         {".yml", "yaml"}
     };
 
-    std::string extension = filename_.substr(filename_.find_last_of('.'));
+    auto dot = filename.find_last_of('.');
+    if (dot == std::string::npos) {
+        return "plaintext";
+    }
+
+    std::string extension = filename.substr(dot);
     std::transform(extension.begin(), extension.end(), extension.begin(), ::tolower);
 
     // Look up the extension in the map
@@ -74,8 +96,8 @@ auto EmbedLexer::getLanguageFromFilename() -> std::string {
 }
 
 auto EmbedLexer::lexTokens() -> void {
-    tokens_.push_back(Token(TokenType::TEXT, "File: " + filename_, "", filename_, 0, 1));
-    tokens_.push_back(Token(TokenType::TEXT, "```" + getLanguageFromFilename(), "", filename_, 0, 1));
+    emitToken(Token(TokenType::TEXT, "File: " + *filename_, "", filename_, 0, 1));
+    emitToken(Token(TokenType::TEXT, "```" + getLanguageFromFilename(*filename_), "", filename_, 0, 1));
 
     // Get the next token.
     while (position_ < input_.size()) {
@@ -86,7 +108,7 @@ auto EmbedLexer::lexTokens() -> void {
             // If we've not seen any non-whitespace characters then emit a blank line.
             if (!seenNonWhitespaceCharacters_) {
                 seenNonWhitespaceCharacters_ = true;
-                tokens_.push_back(Token(TokenType::TEXT, "", line_, filename_, currentLine_, 1));
+                emitToken(Token(TokenType::TEXT, "", line_, filename_, currentLine_, 1));
                 continue;
             }
 
@@ -97,9 +119,9 @@ auto EmbedLexer::lexTokens() -> void {
         }
 
         seenNonWhitespaceCharacters_ = true;
-        tokens_.push_back(readText());
+        emitToken(readText());
     }
 
-    tokens_.push_back(Token(TokenType::TEXT, "```", "", filename_, currentLine_, 1));
-    tokens_.push_back(Token(TokenType::END_OF_FILE, "", line_, filename_, currentLine_, 1));
+    emitToken(Token(TokenType::TEXT, "```", "", filename_, currentLine_, 1));
+    emitToken(Token(TokenType::END_OF_FILE, "", line_, filename_, currentLine_, 1));
 }
@@ -4,16 +4,21 @@
 #include <string>
 
 #include "Lexer.hpp"
+#include "Minifier.hpp"
 
 class EmbedLexer : public Lexer {
 public:
-    EmbedLexer(const std::string& filename);
+    EmbedLexer(const std::string& filename, std::string input, MinifyMode minifyMode = MinifyMode::NONE,
+            TokenRing* ring = nullptr, const CompileLimits* limits = nullptr);
+    EmbedLexer(const std::string& filename, std::string_view input, const CompileLimits* limits = nullptr);
 
+    static auto getLanguageFromFilename(const std::string& filename) -> std::string;
 
 private:
     auto lexTokens() -> void;
     auto readText() -> Token;
-    auto getLanguageFromFilename() -> std::string;
+
+    static auto minifyInput(const std::string& filename, std::string input, MinifyMode minifyMode) -> std::string;
 };
 
 #endif // __EMBEDLEXER_HPP
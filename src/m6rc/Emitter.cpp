@@ -0,0 +1,137 @@
+#include "Emitter.hpp"
+
+Emitter::Emitter(std::ostream& out) :
+        out_(out),
+        text_(&out),
+        sizeReport_(nullptr),
+        limits_(nullptr),
+        outputBytes_(0),
+        sectionFilter_(nullptr),
+        emitting_(true) {
+}
+
+auto Emitter::setSectionFilter(const SectionFilter* sectionFilter) -> void {
+    sectionFilter_ = sectionFilter;
+}
+
+auto Emitter::setLimits(const CompileLimits* limits) -> void {
+    limits_ = limits;
+}
+
+auto Emitter::setSizeReport(SizeReport* sizeReport) -> void {
+    sizeReport_ = sizeReport;
+}
+
+auto Emitter::beginOutput() -> void {
+}
+
+auto Emitter::endOutput() -> void {
+    text_->flush();
+}
+
+auto Emitter::emitHeading(const std::string& section, const std::string& title) -> void {
+    if (title.empty()) {
+        *text_ << section << "\n\n";
+        return;
+    }
+
+    *text_ << section << " " << title << "\n\n";
+}
+
+auto Emitter::emitText(const std::string& text) -> void {
+    *text_ << text << "\n\n";
+}
+
+auto Emitter::recurse(const ASTNode& node, const std::string& section) -> void {
+    switch (node.tokenType_) {
+    case TokenType::TEXT:
+        if (!emitting_) {
+            return;
+        }
+
+        if (limits_) {
+            outputBytes_ += node.value_.size() + 2;
+            limits_->checkOutputBytes(outputBytes_);
+        }
+
+        if (sizeReport_) {
+            sizeReport_->add(currentSection_, *node.filename_, node.value_, 2);
+        }
+
+        emitText(node.value_);
+        return;
+
+    case TokenType::ACTION:
+    case TokenType::CONTEXT:
+    case TokenType::ROLE: {
+        if (sectionFilter_ && !sectionFilter_->isVisited(section)) {
+            return;
+        }
+
+        // Sections that only contain selected sections are walked to number their children, but not output.
+        bool wasEmitting = emitting_;
+        emitting_ = !sectionFilter_ || sectionFilter_->isEmitted(section);
+        if (emitting_) {
+            beginSection(node, section);
+        }
+
+        int index = 0;
+        recurseChildren(node, section, index);
+        emitting_ = wasEmitting;
+        return;
+    }
+
+    default:
+        break;
+    }
+
+    int index = 0;
+    recurseChildren(node, section, index);
+}
+
+auto Emitter::beginSection(const ASTNode& node, const std::string& section) -> void {
+    std::string title;
+    if (node.childNodes_.size()) {
+        const auto& childToken = node.childNodes_[0];
+        if (childToken->tokenType_ == TokenType::KEYWORD_TEXT) {
+            title = childToken->value_;
+        }
+    }
+
+    currentSection_ = section;
+    if (limits_) {
+        outputBytes_ += section.size() + (title.empty() ? 0 : title.size() + 1) + 2;
+        limits_->checkOutputBytes(outputBytes_);
+        limits_->checkDeadline();
+    }
+
+    if (sizeReport_) {
+        sizeReport_->add(section, *node.filename_, title.empty() ? section : section + " " + title, 2);
+    }
+
+    emitHeading(section, title);
+}
+
+// Included subtrees are shared between every place they're used, so their nodes are numbered here, as if they
+// were children of the node that includes them, rather than carrying their own section numbers.
+auto Emitter::recurseChildren(const ASTNode& node, const std::string& section, int& index) -> void {
+    for (const auto& child : node.childNodes_) {
+        if (child->tokenType_ == TokenType::INCLUDE) {
+            recurseChildren(*child->fragment_, section, index);
+            continue;
+        }
+
+        if (child->tokenType_ == TokenType::CONTEXT ||
+                child->tokenType_ == TokenType::ROLE) {
+            index++;
+        }
+
+        recurse(*child, section + "." + std::to_string(index));
+    }
+}
+
+auto Emitter::emit(const ASTNode& node) -> void {
+    beginOutput();
+    recurse(node, "1");
+    endOutput();
+}
@@ -0,0 +1,45 @@
+#ifndef __EMITTER_HPP
+#define __EMITTER_HPP
+
+#include <string>
+#include <ostream>
+
+#include "ASTNode.hpp"
+#include "SizeReport.hpp"
+#include "CompileLimits.hpp"
+#include "SectionFilter.hpp"
+
+class Emitter {
+public:
+    Emitter(std::ostream& out);
+    virtual ~Emitter() = default;
+
+    auto emit(const ASTNode& node) -> void;
+    auto setSizeReport(SizeReport* sizeReport) -> void;
+    auto setLimits(const CompileLimits* limits) -> void;
+    auto setSectionFilter(const SectionFilter* sectionFilter) -> void;
+
+protected:
+    virtual auto beginOutput() -> void;
+    virtual auto endOutput() -> void;
+    virtual auto emitHeading(const std::string& section, const std::string& title) -> void;
+    virtual auto emitText(const std::string& text) -> void;
+
+    std::ostream& out_;                 // Stream the output is written to
+    std::ostream* text_;                // Stream that headings and text are written to
+
+private:
+    SizeReport* sizeReport_;            // If non-null, records the size of everything we emit
+    std::string currentSection_;        // Section that text is currently being emitted into
+    const CompileLimits* limits_;       // If non-null, the resource limits the output must stay within
+    size_t outputBytes_;                // Number of bytes of prompt output emitted so far
+    const SectionFilter* sectionFilter_;
+                                        // If non-null, selects the sections to emit
+    bool emitting_;                     // Is the text of the current section being emitted?
+
+    auto recurse(const ASTNode& node, const std::string& section) -> void;
+    auto beginSection(const ASTNode& node, const std::string& section) -> void;
+    auto recurseChildren(const ASTNode& node, const std::string& section, int& index) -> void;
+};
+
+#endif // __EMITTER_HPP
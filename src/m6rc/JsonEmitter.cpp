@@ -0,0 +1,66 @@
+#include "JsonEmitter.hpp"
+
+JsonEmitter::JsonEmitter(std::ostream& out, JsonFormat format, bool sections) :
+        Emitter(out),
+        format_(format),
+        sections_(sections),
+        inSection_(false),
+        escapeBuf_(out.rdbuf()),
+        escaped_(&escapeBuf_) {
+    text_ = &escaped_;
+}
+
+auto JsonEmitter::beginOutput() -> void {
+    if (sections_) {
+        out_ << "{\"sections\":[";
+        return;
+    }
+
+    if (format_ == JsonFormat::CHAT) {
+        out_ << "{\"messages\":[{\"role\":\"user\",\"content\":\"";
+        return;
+    }
+
+    out_ << "{\"prompt\":\"";
+}
+
+auto JsonEmitter::endOutput() -> void {
+    if (sections_) {
+        if (inSection_) {
+            out_ << "\"}";
+        }
+
+        out_ << "]}\n";
+        out_.flush();
+        return;
+    }
+
+    if (format_ == JsonFormat::CHAT) {
+        out_ << "\"}]}\n";
+        out_.flush();
+        return;
+    }
+
+    out_ << "\"}\n";
+    out_.flush();
+}
+
+auto JsonEmitter::emitHeading(const std::string& section, const std::string& title) -> void {
+    if (!sections_) {
+        Emitter::emitHeading(section, title);
+        return;
+    }
+
+    // Close the text of any previous section and open a new section object.  Any text that follows the
+    // heading is streamed into this section's "text" field.
+    if (inSection_) {
+        out_ << "\"},";
+    }
+
+    inSection_ = true;
+    out_ << "{\"section\":\"";
+    escaped_ << section;
+    out_ << "\",\"heading\":\"";
+    escaped_ << title;
+    out_ << "\",\"text\":\"";
+}
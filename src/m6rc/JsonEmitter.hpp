@@ -0,0 +1,32 @@
+#ifndef __JSONEMITTER_HPP
+#define __JSONEMITTER_HPP
+
+#include <string>
+#include <ostream>
+
+#include "Emitter.hpp"
+#include "JsonStreamBuf.hpp"
+
+enum class JsonFormat {
+    PROMPT,                             // A single JSON object: {"prompt": "..."}
+    CHAT                                // A single JSONL chat request line: {"messages": [{"role": "user", ...}]}
+};
+
+class JsonEmitter : public Emitter {
+public:
+    JsonEmitter(std::ostream& out, JsonFormat format, bool sections);
+
+protected:
+    auto beginOutput() -> void override;
+    auto endOutput() -> void override;
+    auto emitHeading(const std::string& section, const std::string& title) -> void override;
+
+private:
+    JsonFormat format_;                 // Envelope to wrap the output in
+    bool sections_;                     // Are section headings emitted as structured fields?
+    bool inSection_;                    // Have we opened a section object that still needs closing?
+    JsonStreamBuf escapeBuf_;           // Escapes anything written to escaped_
+    std::ostream escaped_;              // Stream used for string contents
+};
+
+#endif // __JSONEMITTER_HPP
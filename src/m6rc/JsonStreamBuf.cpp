@@ -0,0 +1,108 @@
+#include <cstdint>
+#include <cstring>
+#include <algorithm>
+
+#include "JsonStreamBuf.hpp"
+#include "WordScan.hpp"
+
+// Returns true if any of the 8 bytes in the word is a control character, a quote or a backslash.  This lets
+// us skip over clean text a word at a time rather than a byte at a time.
+static inline auto wordNeedsEscape(uint64_t word) -> bool {
+    uint64_t control = (word - ONES * 0x20) & ~word & HIGHS;
+    uint64_t quote = hasZeroByte(word ^ (ONES * '"'));
+    uint64_t backslash = hasZeroByte(word ^ (ONES * '\\'));
+    return (control | quote | backslash) != 0;
+}
+
+JsonStreamBuf::JsonStreamBuf(std::streambuf* dest) :
+        dest_(dest) {
+}
+
+auto JsonStreamBuf::escape(const char* s, size_t n) -> bool {
+    static const char hexDigits[] = "0123456789abcdef";
+
+    size_t runStart = 0;
+    size_t i = 0;
+    while (i < n) {
+        if (i + 8 <= n) {
+            uint64_t word;
+            memcpy(&word, s + i, 8);
+            if (!wordNeedsEscape(word)) {
+                i += 8;
+                continue;
+            }
+        }
+
+        // Something in the next 8 bytes (or the tail) needs escaping, so find it a byte at a time.
+        size_t end = std::min(i + 8, n);
+        for (; i < end; i++) {
+            unsigned char ch = static_cast<unsigned char>(s[i]);
+            if (ch >= 0x20 && ch != '"' && ch != '\\') {
+                continue;
+            }
+
+            size_t runLength = i - runStart;
+            if (runLength && dest_->sputn(s + runStart, runLength) != static_cast<std::streamsize>(runLength)) {
+                return false;
+            }
+
+            runStart = i + 1;
+
+            char seq[6] = {'\\', 0, 0, 0, 0, 0};
+            size_t seqLength = 2;
+            switch (ch) {
+            case '"': seq[1] = '"'; break;
+            case '\\': seq[1] = '\\'; break;
+            case '\b': seq[1] = 'b'; break;
+            case '\f': seq[1] = 'f'; break;
+            case '\n': seq[1] = 'n'; break;
+            case '\r': seq[1] = 'r'; break;
+            case '\t': seq[1] = 't'; break;
+            default:
+                seq[1] = 'u';
+                seq[2] = '0';
+                seq[3] = '0';
+                seq[4] = hexDigits[ch >> 4];
+                seq[5] = hexDigits[ch & 0xf];
+                seqLength = 6;
+                break;
+            }
+
+            if (dest_->sputn(seq, seqLength) != static_cast<std::streamsize>(seqLength)) {
+                return false;
+            }
+        }
+    }
+
+    size_t runLength = n - runStart;
+    if (runLength && dest_->sputn(s + runStart, runLength) != static_cast<std::streamsize>(runLength)) {
+        return false;
+    }
+
+    return true;
+}
+
+auto JsonStreamBuf::overflow(int_type ch) -> int_type {
+    if (traits_type::eq_int_type(ch, traits_type::eof())) {
+        return traits_type::not_eof(ch);
+    }
+
+    char c = traits_type::to_char_type(ch);
+    if (!escape(&c, 1)) {
+        return traits_type::eof();
+    }
+
+    return ch;
+}
+
+auto JsonStreamBuf::xsputn(const char* s, std::streamsize n) -> std::streamsize {
+    if (!escape(s, static_cast<size_t>(n))) {
+        return 0;
+    }
+
+    return n;
+}
+
+auto JsonStreamBuf::sync() -> int {
+    return dest_->pubsync();
+}
@@ -0,0 +1,23 @@
+#ifndef __JSONSTREAMBUF_HPP
+#define __JSONSTREAMBUF_HPP
+
+#include <streambuf>
+
+// Stream buffer that JSON-escapes everything written to it and forwards the result to another stream buffer.
+// Nothing is buffered here, so escaped and unescaped writes to the destination always stay in order.
+class JsonStreamBuf : public std::streambuf {
+public:
+    JsonStreamBuf(std::streambuf* dest);
+
+protected:
+    auto overflow(int_type ch) -> int_type override;
+    auto xsputn(const char* s, std::streamsize n) -> std::streamsize override;
+    auto sync() -> int override;
+
+private:
+    auto escape(const char* s, size_t n) -> bool;
+
+    std::streambuf* dest_;              // Stream buffer that receives the escaped output
+};
+
+#endif // __JSONSTREAMBUF_HPP
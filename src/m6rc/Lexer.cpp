@@ -1,30 +1,41 @@
 #include <cctype>
-#include <iostream>
-#include <fstream>
 
 #include "Lexer.hpp"
 
 #define INDENT_SPACES 4
 
-Lexer::Lexer(const std::string& filename) :
-        filename_(filename),
+// Number of tokens to lex between checks of the compilation deadline.
+#define DEADLINE_CHECK_TOKENS 4096
+
+Lexer::Lexer(const std::string& filename, std::string input, TokenRing* ring, const CompileLimits* limits) :
+        filename_(std::make_shared<const std::string>(filename)),
+        storage_(std::move(input)),
+        input_(storage_),
+        ring_(ring),
+        limits_(limits),
+        emittedTokens_(0),
         position_(0),
         startOfLine_(0),
         endOfLine_(0),
         currentLine_(1),
         currentColumn_(1),
-        seenNonWhitespaceCharacters_(false),
-        nextToken_(0) {
-    if (!std::filesystem::exists(filename)) {
-        throw std::runtime_error("File not found: " + filename);
-    }
-
-    std::ifstream file(filename);
-    if (!file.is_open()) {
-        throw std::runtime_error("Could not open file: " + filename);
-    }
+        seenNonWhitespaceCharacters_(false) {
+    updateEndOfLine();
+}
 
-    input_.assign((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+// The input isn't copied, so it must outlive the lexing.  Tokens hold their own copies of the text.
+Lexer::Lexer(const std::string& filename, std::string_view input, TokenRing* ring, const CompileLimits* limits) :
+        filename_(std::make_shared<const std::string>(filename)),
+        input_(input),
+        ring_(ring),
+        limits_(limits),
+        emittedTokens_(0),
+        position_(0),
+        startOfLine_(0),
+        endOfLine_(0),
+        currentLine_(1),
+        currentColumn_(1),
+        seenNonWhitespaceCharacters_(false) {
     updateEndOfLine();
 }
 
@@ -59,7 +70,28 @@ auto Lexer::consumeNewline() -> void {
     currentColumn_ = 1;
 }
 
-auto Lexer::getNextToken() -> Token {
-    auto token = tokens_[nextToken_++];
-    return token;
+// Tokens are never modified once lexing completes, so one lexer can be shared by any number of readers, each
+// tracking its own index.  This can't be used when tokens are streamed to a ring.  Reading past the end keeps
+// returning the final END_OF_FILE token.
+auto Lexer::getToken(size_t index) const -> const Token& {
+    if (index >= tokens_.size()) {
+        return tokens_.back();
+    }
+
+    return tokens_[index];
+}
+
+// One very large file can take a long time to lex, so the deadline is checked as tokens are produced rather
+// than only when files are loaded.
+auto Lexer::emitToken(Token token) -> void {
+    if (limits_ && ++emittedTokens_ % DEADLINE_CHECK_TOKENS == 0) {
+        limits_->checkDeadline();
+    }
+
+    if (ring_) {
+        ring_->push(std::move(token));
+        return;
+    }
+
+    tokens_.push_back(std::move(token));
 }
\ No newline at end of file
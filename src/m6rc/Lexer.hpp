@@ -2,32 +2,43 @@
 #define __LEXER_HPP
 
 #include <string>
+#include <string_view>
 #include <vector>
 
 #include "Token.hpp"
+#include "TokenRing.hpp"
+#include "CompileLimits.hpp"
 
 class Lexer {
 public:
-    Lexer(const std::string& filename);
+    Lexer(const std::string& filename, std::string input, TokenRing* ring = nullptr,
+            const CompileLimits* limits = nullptr);
+    Lexer(const std::string& filename, std::string_view input, TokenRing* ring = nullptr,
+            const CompileLimits* limits = nullptr);
     virtual ~Lexer() = default;
 
-    auto getNextToken() -> Token;
+    auto getToken(size_t index) const -> const Token&;
 
 protected:
     auto updateEndOfLine() -> void;
     auto consumeNewline() -> void;
+    auto emitToken(Token token) -> void;
 
-    std::string filename_;              // File we're lexing
-    std::string input_;                 // Content being lexed
+    std::shared_ptr<const std::string> filename_;
+                                        // File we're lexing
+    std::string storage_;               // Content being lexed, if the lexer owns it
+    std::string_view input_;            // Content being lexed
     std::string line_;                  // Line curently being lexed
-    std::vector<Token> tokens_;         // All the tokens in the file
+    std::vector<Token> tokens_;         // All the tokens in the file, unless they are being streamed
+    TokenRing* ring_;                   // If non-null, tokens are streamed to this ring instead of being kept
+    const CompileLimits* limits_;       // If non-null, limits whose deadline is checked while lexing
+    size_t emittedTokens_;              // Number of tokens produced so far
     size_t position_;                   // Offset of the current character being lexed
     size_t startOfLine_;                // Offset of the first character of the current line being lexed
     size_t endOfLine_;                  // Offset of the last character of the current line being lexed
     int currentLine_;                   // Current line number being processed (starting at 1)
     int currentColumn_;                 // Current column number being processed (starting at 1)
     bool seenNonWhitespaceCharacters_;  // Have we seen any non-whitespace characters on this line so far?
-    size_t nextToken_;                  // Index of the next token to read
 };
 
 #endif // __LEXER_HPP
@@ -4,4 +4,17 @@ METAPHORC_SRCS += \
 	src/m6rc/Lexer.cpp \
 	src/m6rc/EmbedLexer.cpp \
 	src/m6rc/MetaphorLexer.cpp \
+	src/m6rc/TokenRing.cpp \
+	src/m6rc/TokenStream.cpp \
+	src/m6rc/Emitter.cpp \
+	src/m6rc/JsonEmitter.cpp \
+	src/m6rc/JsonStreamBuf.cpp \
+	src/m6rc/DependencyFile.cpp \
+	src/m6rc/CompileLimits.cpp \
+	src/m6rc/SectionFilter.cpp \
+	src/m6rc/TarArchive.cpp \
+	src/m6rc/Minifier.cpp \
+	src/m6rc/Normalize.cpp \
+	src/m6rc/Simplify.cpp \
+	src/m6rc/SizeReport.cpp \
 	src/m6rc/m6rc.cpp
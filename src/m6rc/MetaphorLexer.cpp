@@ -6,8 +6,9 @@
 
 #define INDENT_SPACES 4
 
-MetaphorLexer::MetaphorLexer(const std::string& filename) :
-        Lexer(filename),
+MetaphorLexer::MetaphorLexer(const std::string& filename, std::string input, TokenRing* ring,
+        const CompileLimits* limits) :
+        Lexer(filename, std::move(input), ring, limits),
         indentColumn_(1),
         processingIndent_(false),
         inTextBlock_(false) {
@@ -22,11 +23,11 @@ auto MetaphorLexer::processIndentation(size_t column) -> void {
 
     if ((indentOffset % INDENT_SPACES) != 0) {
         if (indentOffset > 0) {
-            tokens_.push_back(Token(TokenType::BAD_INDENT, "[Bad indent]", line_, filename_, currentLine_, column));
+            emitToken(Token(TokenType::BAD_INDENT, "[Bad indent]", line_, filename_, currentLine_, column));
             return;
         }
 
-        tokens_.push_back(Token(TokenType::BAD_OUTDENT, "[Bad outdent]", line_, filename_, currentLine_, column));
+        emitToken(Token(TokenType::BAD_OUTDENT, "[Bad outdent]", line_, filename_, currentLine_, column));
         return;
     }
 
@@ -34,7 +35,7 @@ auto MetaphorLexer::processIndentation(size_t column) -> void {
     if (indentOffset >= INDENT_SPACES) {
         while (indentOffset) {
             indentOffset -= INDENT_SPACES;
-            tokens_.push_back(Token(TokenType::INDENT, "[Indent]", line_, filename_, currentLine_, column));
+            emitToken(Token(TokenType::INDENT, "[Indent]", line_, filename_, currentLine_, column));
         }
 
         return;
@@ -42,7 +43,7 @@ auto MetaphorLexer::processIndentation(size_t column) -> void {
 
     while (indentOffset) {
         indentOffset += INDENT_SPACES;
-        tokens_.push_back(Token(TokenType::OUTDENT, "[Outdent]", line_, filename_, currentLine_, column));
+        emitToken(Token(TokenType::OUTDENT, "[Outdent]", line_, filename_, currentLine_, column));
     }
 }
 
@@ -66,20 +67,20 @@ auto MetaphorLexer::readKeywordOrText() -> void {
         currentColumn_++;
     }
 
-    std::string word = input_.substr(startPosition, position_ - startPosition);
+    std::string word(input_.substr(startPosition, position_ - startPosition));
 
     // If we have a keyword then return that.
     if (keyword_map.find(word) != keyword_map.end()) {
         // Once we've seen a keyword, we're no longer in a text block.
         inTextBlock_ = false;
-        tokens_.push_back(Token(keyword_map.at(word), word, line_, filename_, currentLine_, startColumn));
+        emitToken(Token(keyword_map.at(word), word, line_, filename_, currentLine_, startColumn));
         return;
     }
 
     // Have we already seen a keyword?  If yes then this is keyword text
     if (seenNonWhitespaceCharacters_) {
         position_ = endOfLine_;
-        tokens_.push_back(Token(TokenType::KEYWORD_TEXT, line_.substr(startColumn - 1, endOfLine_ - startOfLine_ - (startColumn - 1)), line_, filename_, currentLine_, startColumn));
+        emitToken(Token(TokenType::KEYWORD_TEXT, line_.substr(startColumn - 1, endOfLine_ - startOfLine_ - (startColumn - 1)), line_, filename_, currentLine_, startColumn));
         return;
     }
 
@@ -94,7 +95,7 @@ auto MetaphorLexer::readKeywordOrText() -> void {
 
     inTextBlock_ = true;
     position_ = endOfLine_;
-    tokens_.push_back(Token(TokenType::TEXT, line_.substr(startColumn - 1, endOfLine_ - startOfLine_ - (startColumn - 1)), line_, filename_, currentLine_, startColumn));
+    emitToken(Token(TokenType::TEXT, line_.substr(startColumn - 1, endOfLine_ - startOfLine_ - (startColumn - 1)), line_, filename_, currentLine_, startColumn));
 }
 
 auto MetaphorLexer::lexTokens() -> void {
@@ -107,7 +108,7 @@ auto MetaphorLexer::lexTokens() -> void {
             // If we've not seen any non-whitespace characters and we're in a text block then emit a blank
             // line.  Then pretend we saw characters so next time we process the end of line.
             if (!seenNonWhitespaceCharacters_ && inTextBlock_) {
-                tokens_.push_back(Token(TokenType::TEXT, "", line_, filename_, currentLine_, indentColumn_));
+                emitToken(Token(TokenType::TEXT, "", line_, filename_, currentLine_, indentColumn_));
             }
 
             processingIndent_ = true;
@@ -132,5 +133,5 @@ auto MetaphorLexer::lexTokens() -> void {
         seenNonWhitespaceCharacters_ = true;
     }
 
-    tokens_.push_back(Token(TokenType::END_OF_FILE, "", line_, filename_, currentLine_, 1));
+    emitToken(Token(TokenType::END_OF_FILE, "", line_, filename_, currentLine_, 1));
 }
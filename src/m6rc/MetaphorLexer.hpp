@@ -8,7 +8,8 @@
 
 class MetaphorLexer : public Lexer {
 public:
-    MetaphorLexer(const std::string& filename);
+    MetaphorLexer(const std::string& filename, std::string input, TokenRing* ring = nullptr,
+            const CompileLimits* limits = nullptr);
 
 
 private:
@@ -0,0 +1,475 @@
+#include <cstring>
+#include <algorithm>
+#include <iterator>
+#include <unordered_map>
+
+#include "Minifier.hpp"
+
+static const CommentSyntax C_SYNTAX = {"//", "/*", "*/", "\"", true, true, false, false, false, false, true};
+static const CommentSyntax CPP_SYNTAX = {"//", "/*", "*/", "\"", true, true, false, true, false, false, true};
+static const CommentSyntax CSHARP_SYNTAX = {"//", "/*", "*/", "\"", true, true, false, false, true, false, true};
+static const CommentSyntax JS_SYNTAX = {"//", "/*", "*/", "\"'`", true, false, false, false, false, true, true};
+static const CommentSyntax GO_SYNTAX = {"//", "/*", "*/", "\"`", true, true, false, false, false, false, true};
+static const CommentSyntax PHP_SYNTAX = {"//", "/*", "*/", "\"'", true, false, false, false, false, false, true};
+static const CommentSyntax CSS_SYNTAX = {nullptr, "/*", "*/", "\"'", true, false, false, false, false, false, true};
+static const CommentSyntax HASH_SYNTAX = {"#", nullptr, nullptr, "\"'", true, false, true, false, false, false, true};
+static const CommentSyntax SQL_SYNTAX = {"--", "/*", "*/", "\"'", false, false, false, false, false, false, true};
+static const CommentSyntax LUA_SYNTAX = {"--", "--[[", "]]", "\"'", true, false, false, false, false, false, true};
+static const CommentSyntax HASKELL_SYNTAX = {"--", "{-", "-}", "\"", true, true, false, false, false, false, true};
+static const CommentSyntax LISP_SYNTAX = {";", nullptr, nullptr, "\"", true, false, false, false, false, false, true};
+static const CommentSyntax ERLANG_SYNTAX = {"%", nullptr, nullptr, "\"", true, false, false, false, false, false, true};
+static const CommentSyntax BASIC_SYNTAX = {"'", nullptr, nullptr, "\"", false, false, false, false, false, false, true};
+static const CommentSyntax MARKUP_SYNTAX = {nullptr, "<!--", "-->", "", false, false, false, false, false, false, true};
+static const CommentSyntax NO_SYNTAX = {nullptr, nullptr, nullptr, "", false, false, false, false, false, false, true};
+
+// Shell heredocs and the regular expressions and quoting operators of Perl and Ruby can all hold a '#' that
+// isn't a comment, so these languages are only ever license stripped.
+static const CommentSyntax SH_SYNTAX = {"#", nullptr, nullptr, "\"'", true, false, true, false, false, false, false};
+
+Minifier::Minifier(const std::string& language) {
+    static const std::unordered_map<std::string, const CommentSyntax*> languageToSyntax = {
+        {"bash", &SH_SYNTAX},
+        {"c", &C_SYNTAX},
+        {"clojure", &LISP_SYNTAX},
+        {"cpp", &CPP_SYNTAX},
+        {"csharp", &CSHARP_SYNTAX},
+        {"css", &CSS_SYNTAX},
+        {"dart", &JS_SYNTAX},
+        {"elixir", &HASH_SYNTAX},
+        {"erlang", &ERLANG_SYNTAX},
+        {"go", &GO_SYNTAX},
+        {"groovy", &JS_SYNTAX},
+        {"haskell", &HASKELL_SYNTAX},
+        {"html", &MARKUP_SYNTAX},
+        {"java", &C_SYNTAX},
+        {"javascript", &JS_SYNTAX},
+        {"kotlin", &C_SYNTAX},
+        {"lua", &LUA_SYNTAX},
+        {"objectivec", &C_SYNTAX},
+        {"perl", &SH_SYNTAX},
+        {"php", &PHP_SYNTAX},
+        {"python", &HASH_SYNTAX},
+        {"r", &HASH_SYNTAX},
+        {"racket", &LISP_SYNTAX},
+        {"ruby", &SH_SYNTAX},
+        {"rust", &C_SYNTAX},
+        {"scala", &C_SYNTAX},
+        {"sql", &SQL_SYNTAX},
+        {"swift", &C_SYNTAX},
+        {"typescript", &JS_SYNTAX},
+        {"vbnet", &BASIC_SYNTAX},
+        {"vbscript", &BASIC_SYNTAX},
+        {"xml", &MARKUP_SYNTAX},
+        {"yaml", &HASH_SYNTAX}
+    };
+
+    // Languages we don't know the comment syntax for still get whitespace minification.
+    auto it = languageToSyntax.find(language);
+    syntax_ = (it != languageToSyntax.end()) ? it->second : &NO_SYNTAX;
+}
+
+auto Minifier::startsWith(const std::string& text, size_t pos, const char* prefix) const -> bool {
+    return prefix && text[pos] == prefix[0] && text.compare(pos, strlen(prefix), prefix) == 0;
+}
+
+// Returns the offset just past the string or character literal that starts at pos, or pos if there isn't one.
+auto Minifier::skipString(const std::string& text, size_t pos) const -> size_t {
+    size_t size = text.size();
+    char quote = text[pos];
+
+    if (quote == 'R' && syntax_->rawStrings) {
+        return skipRawString(text, pos);
+    }
+
+    if (quote == '@' && syntax_->verbatimStrings) {
+        return skipVerbatimString(text, pos);
+    }
+
+    if (quote && strchr(syntax_->quotes, quote)) {
+        // Triple-quoted strings (Python, Kotlin, Swift and others) end at the next triple quote.
+        if (pos + 2 < size && text[pos + 1] == quote && text[pos + 2] == quote) {
+            size_t end = text.find(std::string(3, quote), pos + 3);
+            return (end == std::string::npos) ? size : end + 3;
+        }
+
+        size_t i = pos + 1;
+        while (i < size) {
+            char ch = text[i++];
+            if (ch == '\\' && syntax_->backslashEscapes) {
+                i++;
+                continue;
+            }
+
+            if (ch == quote) {
+                break;
+            }
+        }
+
+        return std::min(i, size);
+    }
+
+    // Character literals are short, so only treat a quote as one if it closes within a few characters on the
+    // same line.  Anything else, such as a Rust lifetime, is left alone.
+    if (quote == '\'' && syntax_->charLiterals) {
+        size_t limit = std::min(pos + 12, size);
+        for (size_t i = pos + 1; i < limit && text[i] != '\n'; i++) {
+            if (text[i] == '\\') {
+                i++;
+                continue;
+            }
+
+            if (text[i] == '\'') {
+                return (i > pos + 1) ? i + 1 : pos;
+            }
+
+            // Unescaped character literals hold a single character.
+            if (text[pos + 1] != '\\' && i > pos + 1) {
+                break;
+            }
+        }
+    }
+
+    return pos;
+}
+
+// C++ raw strings, R"delim(...)delim", can hold quotes, backslashes and comment markers, and only end at the
+// closing delimiter.  The R may follow an encoding prefix (u8, u, U or L), but not any other identifier.
+auto Minifier::skipRawString(const std::string& text, size_t pos) const -> size_t {
+    size_t size = text.size();
+    if (pos + 1 >= size || text[pos + 1] != '"') {
+        return pos;
+    }
+
+    size_t prefixStart = pos;
+    while (prefixStart > 0 && (isalnum(static_cast<unsigned char>(text[prefixStart - 1])) ||
+            text[prefixStart - 1] == '_')) {
+        prefixStart--;
+    }
+
+    auto prefix = text.substr(prefixStart, pos - prefixStart);
+    if (!prefix.empty() && prefix != "u8" && prefix != "u" && prefix != "U" && prefix != "L") {
+        return pos;
+    }
+
+    // The delimiter is at most 16 characters, and can't contain spaces, parentheses or backslashes.
+    size_t open = pos + 2;
+    while (open < size && open - pos - 2 <= 16 && !strchr(" ()\\\t\v\f\n", text[open])) {
+        open++;
+    }
+
+    if (open >= size || text[open] != '(' || open - pos - 2 > 16) {
+        return pos;
+    }
+
+    std::string terminator = ")" + text.substr(pos + 2, open - pos - 2) + "\"";
+    size_t end = text.find(terminator, open + 1);
+    return (end == std::string::npos) ? size : end + terminator.size();
+}
+
+// C# verbatim strings, @"...", have no backslash escapes and write a quote as "".  The @ can come either side
+// of the $ of an interpolated string; when the $ comes first it has already been copied as an ordinary character.
+auto Minifier::skipVerbatimString(const std::string& text, size_t pos) const -> size_t {
+    size_t size = text.size();
+    size_t i = pos + 1;
+    if (i < size && text[i] == '$') {
+        i++;
+    }
+
+    if (i >= size || text[i] != '"') {
+        return pos;
+    }
+
+    for (i++; i < size; i++) {
+        if (text[i] != '"') {
+            continue;
+        }
+
+        if (i + 1 < size && text[i + 1] == '"') {
+            i++;
+            continue;
+        }
+
+        return i + 1;
+    }
+
+    return size;
+}
+
+// Returns true if a '/' following the text already written would start an operand rather than be a division.
+// That's the case after an operator or opening bracket, at the start of the text, and after the keywords that
+// can be followed by an expression.
+static auto expectsOperand(const std::string& text, size_t writePos) -> bool {
+    size_t end = writePos;
+    while (end > 0 && isspace(static_cast<unsigned char>(text[end - 1]))) {
+        end--;
+    }
+
+    if (end == 0) {
+        return true;
+    }
+
+    char ch = text[end - 1];
+    if (ch == ')' || ch == ']' || ch == '"' || ch == '\'' || ch == '`') {
+        return false;
+    }
+
+    if (!isalnum(static_cast<unsigned char>(ch)) && ch != '_' && ch != '$') {
+        return true;
+    }
+
+    size_t start = end;
+    while (start > 0 && (isalnum(static_cast<unsigned char>(text[start - 1])) || text[start - 1] == '_' ||
+            text[start - 1] == '$')) {
+        start--;
+    }
+
+    static const char* keywords[] = {
+        "await", "case", "delete", "do", "else", "in", "instanceof", "new", "of", "return", "throw", "typeof",
+        "void", "yield"
+    };
+
+    auto word = text.substr(start, end - start);
+    return std::find(std::begin(keywords), std::end(keywords), word) != std::end(keywords);
+}
+
+// JavaScript regular expression literals, /.../flags, can hold quotes and comment markers.  They can't span
+// lines, and a '/' inside a [...] character class doesn't end them.  Comments have already been ruled out, so
+// the '/' isn't followed by another '/' or a '*'.
+auto Minifier::skipRegex(const std::string& text, size_t pos, size_t writePos) const -> size_t {
+    if (!syntax_->regexLiterals || text[pos] != '/' || !expectsOperand(text, writePos)) {
+        return pos;
+    }
+
+    size_t size = text.size();
+    bool inClass = false;
+    for (size_t i = pos + 1; i < size && text[i] != '\n'; i++) {
+        char ch = text[i];
+        if (ch == '\\') {
+            if (i + 1 < size && text[i + 1] == '\n') {
+                break;
+            }
+
+            i++;
+            continue;
+        }
+
+        if (ch == '[') {
+            inClass = true;
+        } else if (ch == ']') {
+            inClass = false;
+        } else if (ch == '/' && !inClass) {
+            // Skip any flags.
+            i++;
+            while (i < size && isalpha(static_cast<unsigned char>(text[i]))) {
+                i++;
+            }
+
+            return i;
+        }
+    }
+
+    return pos;
+}
+
+// Single pass over the text that compacts it in place: the write offset never overtakes the read offset,
+// so no second buffer is needed.  Comments are dropped, string literals are copied verbatim, lines that
+// only held comments are removed, trailing whitespace is trimmed and runs of blank lines become one.
+auto Minifier::stripComments(std::string& text) const -> void {
+    char* data = text.data();
+    size_t size = text.size();
+    size_t readPos = 0;
+    size_t writePos = 0;
+    size_t lineStart = 0;
+    bool lineHasContent = false;
+    bool lineHadComment = false;
+    bool lastLineBlank = true;
+
+    auto endLine = [&]() {
+        if (!lineHasContent) {
+            writePos = lineStart;
+            if (!lineHadComment && !lastLineBlank) {
+                data[writePos++] = '\n';
+                lastLineBlank = true;
+            }
+        } else {
+            while (writePos > lineStart && isspace(static_cast<unsigned char>(data[writePos - 1]))) {
+                writePos--;
+            }
+
+            data[writePos++] = '\n';
+            lastLineBlank = false;
+        }
+
+        lineStart = writePos;
+        lineHasContent = false;
+        lineHadComment = false;
+    };
+
+    // Preserve any "#!" interpreter line.
+    if (startsWith(text, 0, "#!")) {
+        while (readPos < size && data[readPos] != '\n') {
+            data[writePos++] = data[readPos++];
+        }
+
+        lineHasContent = true;
+    }
+
+    while (readPos < size) {
+        char ch = data[readPos];
+        if (ch == '\n') {
+            readPos++;
+            endLine();
+            continue;
+        }
+
+        // Block comments are checked first as Lua's "--[[" starts with its line comment marker.
+        if (startsWith(text, readPos, syntax_->blockStart)) {
+            size_t end = text.find(syntax_->blockEnd, readPos + strlen(syntax_->blockStart));
+            end = (end == std::string::npos) ? size : end + strlen(syntax_->blockEnd);
+            bool multiLine = memchr(data + readPos, '\n', end - readPos) != nullptr;
+            readPos = end;
+            lineHadComment = true;
+            if (multiLine) {
+                endLine();
+            }
+
+            // Don't leave a double gap where the comment was.
+            if (writePos == lineStart || data[writePos - 1] == ' ' || data[writePos - 1] == '\t') {
+                while (readPos < size && (data[readPos] == ' ' || data[readPos] == '\t')) {
+                    readPos++;
+                }
+            }
+
+            continue;
+        }
+
+        if (startsWith(text, readPos, syntax_->lineComment)) {
+            bool atWordStart = (readPos == 0) || isspace(static_cast<unsigned char>(data[readPos - 1]));
+            if (!syntax_->wordComments || atWordStart) {
+                while (readPos < size && data[readPos] != '\n') {
+                    readPos++;
+                }
+
+                lineHadComment = true;
+                continue;
+            }
+        }
+
+        size_t end = skipString(text, readPos);
+        if (end == readPos) {
+            end = skipRegex(text, readPos, writePos);
+        }
+
+        if (end != readPos) {
+            memmove(data + writePos, data + readPos, end - readPos);
+            writePos += end - readPos;
+            readPos = end;
+            lineHasContent = true;
+            continue;
+        }
+
+        data[writePos++] = ch;
+        readPos++;
+        if (!isspace(static_cast<unsigned char>(ch))) {
+            lineHasContent = true;
+        }
+    }
+
+    // Handle a final line with no newline, then drop any trailing blank lines.
+    if (lineHasContent) {
+        while (writePos > lineStart && isspace(static_cast<unsigned char>(data[writePos - 1]))) {
+            writePos--;
+        }
+    } else {
+        writePos = lineStart;
+    }
+
+    while (writePos >= 2 && data[writePos - 1] == '\n' && data[writePos - 2] == '\n') {
+        writePos--;
+    }
+
+    text.resize(writePos);
+}
+
+// Removes the first comment block in a file if it looks like a license or copyright notice.
+auto Minifier::stripLicense(std::string& text) const -> void {
+    size_t size = text.size();
+    size_t pos = 0;
+
+    if (startsWith(text, 0, "#!")) {
+        pos = text.find('\n');
+        if (pos == std::string::npos) {
+            return;
+        }
+
+        pos++;
+    }
+
+    // Find the first non-blank line.
+    size_t start = pos;
+    while (pos < size && isspace(static_cast<unsigned char>(text[pos]))) {
+        if (text[pos++] == '\n') {
+            start = pos;
+        }
+    }
+
+    size_t end = start;
+    if (startsWith(text, pos, syntax_->blockStart)) {
+        end = text.find(syntax_->blockEnd, pos + strlen(syntax_->blockStart));
+        if (end == std::string::npos) {
+            return;
+        }
+
+        end = text.find('\n', end);
+        end = (end == std::string::npos) ? size : end + 1;
+    } else {
+        while (startsWith(text, pos, syntax_->lineComment)) {
+            end = text.find('\n', pos);
+            end = (end == std::string::npos) ? size : end + 1;
+            pos = end;
+            while (pos < size && (text[pos] == ' ' || text[pos] == '\t')) {
+                pos++;
+            }
+        }
+    }
+
+    if (end == start) {
+        return;
+    }
+
+    std::string block = text.substr(start, end - start);
+    std::transform(block.begin(), block.end(), block.begin(), ::tolower);
+    if (block.find("copyright") == std::string::npos && block.find("licen") == std::string::npos) {
+        return;
+    }
+
+    // Take any blank lines that followed the notice with it.
+    while (end < size && isspace(static_cast<unsigned char>(text[end]))) {
+        size_t next = text.find('\n', end);
+        if (next == std::string::npos || text.find_first_not_of(" \t\r", end) < next) {
+            break;
+        }
+
+        end = next + 1;
+    }
+
+    text.erase(start, end - start);
+}
+
+auto Minifier::minify(std::string& text, MinifyMode mode) const -> void {
+    switch (mode) {
+    case MinifyMode::NONE:
+        return;
+
+    case MinifyMode::LICENSE:
+        stripLicense(text);
+        return;
+
+    case MinifyMode::FULL:
+        if (syntax_->strippable) {
+            stripComments(text);
+        }
+
+        return;
+    }
+}
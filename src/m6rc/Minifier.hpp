@@ -0,0 +1,45 @@
+#ifndef __MINIFIER_HPP
+#define __MINIFIER_HPP
+
+#include <string>
+
+enum class MinifyMode {
+    NONE,                               // Leave embedded files unchanged
+    LICENSE,                            // Remove a leading license or copyright comment block
+    FULL                                // Remove all comments, trailing whitespace and runs of blank lines
+};
+
+// Describes the comment and string literal syntax of a language.
+struct CommentSyntax {
+    const char* lineComment;            // Start of a comment that runs to the end of the line, or nullptr
+    const char* blockStart;             // Start of a block comment, or nullptr
+    const char* blockEnd;               // End of a block comment
+    const char* quotes;                 // Characters that delimit string literals
+    bool backslashEscapes;              // Can a backslash escape a quote within a string literal?
+    bool charLiterals;                  // Are short '...' sequences character literals (or lifetimes in Rust)?
+    bool wordComments;                  // Must line comments start at the beginning of a word (e.g. # in shell)?
+    bool rawStrings;                    // Are there C++ style R"delim(...)delim" raw string literals?
+    bool verbatimStrings;               // Are there C# style @"..." verbatim string literals?
+    bool regexLiterals;                 // Are there JavaScript style /.../ regular expression literals?
+    bool strippable;                    // Can comments be found reliably enough to remove them all?
+};
+
+class Minifier {
+public:
+    Minifier(const std::string& language);
+
+    auto minify(std::string& text, MinifyMode mode) const -> void;
+
+private:
+    auto stripComments(std::string& text) const -> void;
+    auto stripLicense(std::string& text) const -> void;
+    auto startsWith(const std::string& text, size_t pos, const char* prefix) const -> bool;
+    auto skipString(const std::string& text, size_t pos) const -> size_t;
+    auto skipRawString(const std::string& text, size_t pos) const -> size_t;
+    auto skipVerbatimString(const std::string& text, size_t pos) const -> size_t;
+    auto skipRegex(const std::string& text, size_t pos, size_t writePos) const -> size_t;
+
+    const CommentSyntax* syntax_;       // Syntax of the language being minified
+};
+
+#endif // __MINIFIER_HPP
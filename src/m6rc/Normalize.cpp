@@ -0,0 +1,206 @@
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+
+#include "Normalize.hpp"
+#include "WordScan.hpp"
+
+// Returns true if any of the 8 bytes in the word is a carriage return, a NUL, or not 7-bit ASCII.
+static inline auto wordNeedsWork(uint64_t word) -> bool {
+    return ((word & HIGHS) | hasZeroByte(word) | hasZeroByte(word ^ (ONES * '\r'))) != 0;
+}
+
+// Returns the offset of the first byte at or after start that needs normalizing or checking, or the size of
+// the input if there isn't one.  Plain ASCII is skipped a word at a time.
+static auto findNextSpecial(std::string_view input, size_t start) -> size_t {
+    const char* data = input.data();
+    size_t size = input.size();
+    size_t i = start;
+
+    while (i + 8 <= size) {
+        uint64_t word;
+        memcpy(&word, data + i, 8);
+        if (wordNeedsWork(word)) {
+            break;
+        }
+
+        i += 8;
+    }
+
+    for (; i < size; i++) {
+        unsigned char ch = static_cast<unsigned char>(data[i]);
+        if (ch == '\r' || ch == 0 || ch >= 0x80) {
+            return i;
+        }
+    }
+
+    return size;
+}
+
+// Builds an error for the character at the end of the normalized output so far.
+static auto inputError(const std::string& message, const std::string& filename, const std::string& output,
+        size_t outputSize) -> std::runtime_error {
+    int line = 1;
+    size_t startOfLine = 0;
+    for (size_t i = 0; i < outputSize; i++) {
+        if (output[i] == '\n') {
+            line++;
+            startOfLine = i + 1;
+        }
+    }
+
+    int column = static_cast<int>(outputSize - startOfLine) + 1;
+    return std::runtime_error(message + ": line " + std::to_string(line) + ", column " + std::to_string(column) +
+            ", file " + filename);
+}
+
+// Returns the length of the valid UTF-8 sequence starting at offset i, or 0 if it isn't valid.
+static auto utf8SequenceLength(const std::string& input, size_t i) -> size_t {
+    auto byte = [&](size_t offset) -> unsigned {
+        return (i + offset < input.size()) ? static_cast<unsigned char>(input[i + offset]) : 0;
+    };
+
+    auto isContinuation = [](unsigned ch) {
+        return (ch & 0xc0) == 0x80;
+    };
+
+    unsigned ch = byte(0);
+    if (ch >= 0xc2 && ch <= 0xdf) {
+        return isContinuation(byte(1)) ? 2 : 0;
+    }
+
+    if (ch >= 0xe0 && ch <= 0xef) {
+        // Reject overlong encodings and UTF-16 surrogates.
+        unsigned low = (ch == 0xe0) ? 0xa0 : 0x80;
+        unsigned high = (ch == 0xed) ? 0x9f : 0xbf;
+        return (byte(1) >= low && byte(1) <= high && isContinuation(byte(2))) ? 3 : 0;
+    }
+
+    if (ch >= 0xf0 && ch <= 0xf4) {
+        // Reject overlong encodings and anything above U+10FFFF.
+        unsigned low = (ch == 0xf0) ? 0x90 : 0x80;
+        unsigned high = (ch == 0xf4) ? 0x8f : 0xbf;
+        return (byte(1) >= low && byte(1) <= high && isContinuation(byte(2)) && isContinuation(byte(3))) ? 4 : 0;
+    }
+
+    return 0;
+}
+
+static auto appendUtf8(std::string& output, uint32_t codePoint) -> void {
+    if (codePoint < 0x80) {
+        output += static_cast<char>(codePoint);
+    } else if (codePoint < 0x800) {
+        output += static_cast<char>(0xc0 | (codePoint >> 6));
+        output += static_cast<char>(0x80 | (codePoint & 0x3f));
+    } else if (codePoint < 0x10000) {
+        output += static_cast<char>(0xe0 | (codePoint >> 12));
+        output += static_cast<char>(0x80 | ((codePoint >> 6) & 0x3f));
+        output += static_cast<char>(0x80 | (codePoint & 0x3f));
+    } else {
+        output += static_cast<char>(0xf0 | (codePoint >> 18));
+        output += static_cast<char>(0x80 | ((codePoint >> 12) & 0x3f));
+        output += static_cast<char>(0x80 | ((codePoint >> 6) & 0x3f));
+        output += static_cast<char>(0x80 | (codePoint & 0x3f));
+    }
+}
+
+// Transcodes UTF-16, after its byte order mark, to UTF-8.
+static auto transcodeUtf16(const std::string& filename, const std::string& input, bool bigEndian) -> std::string {
+    if (input.size() % 2) {
+        throw std::runtime_error("Truncated UTF-16 input, file " + filename);
+    }
+
+    auto unit = [&](size_t i) -> uint32_t {
+        uint32_t first = static_cast<unsigned char>(input[i]);
+        uint32_t second = static_cast<unsigned char>(input[i + 1]);
+        return bigEndian ? ((first << 8) | second) : ((second << 8) | first);
+    };
+
+    std::string output;
+    output.reserve(input.size() / 2);
+
+    for (size_t i = 2; i < input.size(); i += 2) {
+        uint32_t codePoint = unit(i);
+        if (codePoint >= 0xd800 && codePoint <= 0xdbff) {
+            uint32_t low = (i + 2 < input.size()) ? unit(i + 2) : 0;
+            if (low < 0xdc00 || low > 0xdfff) {
+                throw inputError("Invalid UTF-16 surrogate pair", filename, output, output.size());
+            }
+
+            codePoint = 0x10000 + ((codePoint - 0xd800) << 10) + (low - 0xdc00);
+            i += 2;
+        } else if (codePoint >= 0xdc00 && codePoint <= 0xdfff) {
+            throw inputError("Invalid UTF-16 surrogate pair", filename, output, output.size());
+        }
+
+        appendUtf8(output, codePoint);
+    }
+
+    return output;
+}
+
+auto normalizeInput(const std::string& filename, std::string& input) -> void {
+    if (input.size() >= 2) {
+        unsigned char first = static_cast<unsigned char>(input[0]);
+        unsigned char second = static_cast<unsigned char>(input[1]);
+        if ((first == 0xff && second == 0xfe) || (first == 0xfe && second == 0xff)) {
+            input = transcodeUtf16(filename, input, first == 0xfe);
+        }
+    }
+
+    size_t start = 0;
+    if (input.compare(0, 3, "\xef\xbb\xbf") == 0) {
+        start = 3;
+    }
+
+    // Most files are already clean, so find that out as quickly as possible and leave them alone.
+    size_t i = findNextSpecial(input, start);
+    if (i == input.size() && !start) {
+        return;
+    }
+
+    // Otherwise rewrite the input in place.  The output is never longer than the input.
+    size_t out = i - start;
+    if (out != i) {
+        memmove(&input[0], &input[start], out);
+    }
+
+    while (i < input.size()) {
+        unsigned char ch = static_cast<unsigned char>(input[i]);
+        if (ch == '\r') {
+            input[out++] = '\n';
+            i++;
+            if (i < input.size() && input[i] == '\n') {
+                i++;
+            }
+        } else if (ch == 0) {
+            throw inputError("Unexpected NUL character (UTF-16 files need a byte order mark)", filename, input, out);
+        } else if (ch >= 0x80) {
+            size_t length = utf8SequenceLength(input, i);
+            if (!length) {
+                throw inputError("Invalid UTF-8", filename, input, out);
+            }
+
+            if (out != i) {
+                memmove(&input[out], &input[i], length);
+            }
+
+            out += length;
+            i += length;
+        }
+
+        size_t next = findNextSpecial(input, i);
+        if (out != i) {
+            memmove(&input[out], &input[i], next - i);
+        }
+
+        out += next - i;
+        i = next;
+    }
+
+    input.resize(out);
+}
+
+auto isNormalized(std::string_view input) -> bool {
+    return findNextSpecial(input, 0) == input.size();
+}
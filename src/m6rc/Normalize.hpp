@@ -0,0 +1,14 @@
+#ifndef __NORMALIZE_HPP
+#define __NORMALIZE_HPP
+
+#include <string>
+#include <string_view>
+
+// Convert file contents to the form the lexers expect: UTF-8, without a byte order mark, with LF line endings.
+// UTF-16 input with a byte order mark is transcoded.  Throws std::runtime_error if the input isn't valid.
+auto normalizeInput(const std::string& filename, std::string& input) -> void;
+
+// Returns true if normalizeInput() would leave the input unchanged, so it can be lexed where it is.
+auto isNormalized(std::string_view input) -> bool;
+
+#endif // __NORMALIZE_HPP
@@ -1,34 +1,108 @@
+#include <fstream>
+#include <algorithm>
+#include <thread>
+#include <exception>
+
 #include "Parser.hpp"
 #include "EmbedLexer.hpp"
 #include "MetaphorLexer.hpp"
+#include "Normalize.hpp"
+
+// When choosing the number of parse threads automatically, give each thread at least this many tokens and this
+// many top-level blocks.  Below that, starting threads costs more than it saves.
+#define MIN_TOKENS_PER_THREAD 16384
+#define MIN_BLOCKS_PER_THREAD 16
+
+// Maximum number of tokens a pipelined lexer can get ahead of the parser.
+#define TOKEN_RING_SIZE 4096
+
+Parser::Parser() :
+        sharedFiles_(nullptr),
+        buffers_(std::make_shared<std::map<std::filesystem::path, std::string>>()),
+        minifyMode_(MinifyMode::NONE),
+        inputBytes_(0),
+        deepestInclude_(0),
+        parseThreads_(0),
+        pipelined_(false),
+        rangeEndReads_(0) {
+}
+
+// Included files are identified by their absolute, normalized, path.
+static auto canonicalPath(const std::string& filename) -> std::filesystem::path {
+    return std::filesystem::absolute(filename).lexically_normal();
+}
+
+// Files inside tar archives are named "<archive>.tar//<member>".  Returns false for any other file name.
+static auto splitArchivePath(const std::string& filename, std::string& archiveName, std::string& member) -> bool {
+    auto separator = filename.find(".tar//");
+    if (separator == std::string::npos) {
+        return false;
+    }
+
+    archiveName = filename.substr(0, separator + 4);
+    member = filename.substr(separator + 6);
+    return true;
+}
+
+Parser::Parser(const std::map<std::string, std::string>& buffers) :
+        sharedFiles_(nullptr),
+        minifyMode_(MinifyMode::NONE),
+        inputBytes_(0),
+        deepestInclude_(0),
+        parseThreads_(0),
+        pipelined_(false),
+        rangeEndReads_(0) {
+    auto canonicalBuffers = std::make_shared<std::map<std::filesystem::path, std::string>>();
+    for (const auto& [filename, contents] : buffers) {
+        (*canonicalBuffers)[canonicalPath(filename)] = contents;
+    }
 
-Parser::Parser() {
+    buffers_ = canonicalBuffers;
 }
 
 auto Parser::getNextToken() -> Token {
     while (!lexers_.empty()) {
-        auto& lexer = lexers_.back();
-        auto token = lexer->getNextToken();
+        auto& state = lexers_.back();
 
-        switch (token.type) {
-        case TokenType::INCLUDE:
-            parseInclude();
-            break;
+        // When parsing part of a file, the end of the range looks like the end of the file.
+        if (state.nextToken >= state.endToken) {
+            rangeEndReads_++;
+            return state.lexer->getToken(SIZE_MAX);
+        }
 
-        case TokenType::EMBED:
-            parseEmbed();
-            break;
+        const auto& token = state.stream ? state.stream->peek() : state.lexer->getToken(state.nextToken);
+
+        // Embedded files are spliced into the stream of the file that embeds them, but the end of any other
+        // file ends the fragment being parsed from it.  parse() and parseInclude() pop those lexers.
+        if (token.type == TokenType::END_OF_FILE) {
+            if (!state.spliced) {
+                return token;
+            }
 
-        case TokenType::END_OF_FILE:
             lexers_.pop_back();
-            break;
+            continue;
+        }
 
-        default:
-            return token;
+        if (token.type == TokenType::EMBED) {
+            if (state.stream) {
+                state.stream->take();
+            } else {
+                state.nextToken++;
+            }
+
+            parseEmbed();
+            continue;
         }
+
+        if (state.stream) {
+            return state.stream->take();
+        }
+
+        state.nextToken++;
+        return token;
     }
 
-    return Token(TokenType::END_OF_FILE, "", "", "", 0, 0);
+    return Token(TokenType::END_OF_FILE, "", "", std::make_shared<const std::string>(), 0, 0);
 }
 
 auto Parser::raiseSyntaxError(const Token& token, const std::string& message) -> void {
@@ -38,34 +112,378 @@ auto Parser::raiseSyntaxError(const Token& token, const std::string& message) ->
     }
 
     std::string errorMessage = message + ": line " + std::to_string(token.line) +
-                                ", column " + std::to_string(token.column) + ", file " + token.filename +
+                                ", column " + std::to_string(token.column) + ", file " + *token.filename +
                                 "\n" + caret + "|\n" + caret + "v\n" + token.input;
     parseErrors_.push_back(errorMessage);
+    errorFiles_.push_back(includeStack_.empty() ? std::filesystem::path() : includeStack_.back());
+}
+
+// Starts reading tokens from a file.  When pipelined, the file is lexed on its own thread as it is parsed.
+auto Parser::pushLexer(const std::string& filename, bool embed) -> void {
+    if (pipelined_) {
+        // Streamed tokens can't be replayed, so embedded files are lexed again each time they are used.
+        auto stream = std::make_shared<TokenStream>(filename, loadFile(filename), embed, minifyMode_,
+                TOKEN_RING_SIZE, &limits_);
+        lexers_.push_back({nullptr, stream, 0, embed});
+        return;
+    }
+
+    if (!embed) {
+        auto lexer = std::make_shared<MetaphorLexer>(filename, loadFile(filename), nullptr, &limits_);
+        lexers_.push_back({lexer, nullptr, 0, false});
+        return;
+    }
+
+    // Embedded files can be used any number of times, but are only read and lexed once.
+    auto& lexer = embedLexers_[canonicalPath(filename)];
+    if (!lexer) {
+        // Archive members that need no normalizing or minifying are lexed straight from the archive.
+        std::string archiveName;
+        std::string member;
+        if (minifyMode_ == MinifyMode::NONE && splitArchivePath(filename, archiveName, member)) {
+            auto contents = loadArchiveMember(filename, archiveName, member);
+            if (isNormalized(contents)) {
+                lexer = std::make_shared<EmbedLexer>(filename, contents, &limits_);
+            } else {
+                std::string normalized(contents);
+                normalizeInput(filename, normalized);
+                lexer = std::make_shared<EmbedLexer>(filename, std::move(normalized), MinifyMode::NONE, nullptr,
+                        &limits_);
+            }
+        } else {
+            lexer = std::make_shared<EmbedLexer>(filename, loadFile(filename), minifyMode_, nullptr, &limits_);
+        }
+    }
+
+    lexers_.push_back({lexer, nullptr, 0, true});
 }
 
 auto Parser::getSyntaxErrors() -> std::vector<std::string> {
     return parseErrors_;
 }
 
-auto Parser::loadFile(const std::string& filename) -> void {
-    std::filesystem::path canonicalFilename = std::filesystem::absolute(filename);
+// All file reads come through here, so this is where input budgets are enforced and where contents are
+// normalized for the lexers.  Sizes are checked before anything is read so an oversized file never gets loaded.
+auto Parser::loadFile(const std::string& filename) -> std::string {
+    std::string archiveName;
+    std::string member;
+    if (splitArchivePath(filename, archiveName, member)) {
+        std::string contents(loadArchiveMember(filename, archiveName, member));
+        normalizeInput(filename, contents);
+        return contents;
+    }
+
+    limits_.checkDeadline();
+
+    std::filesystem::path canonicalFilename = canonicalPath(filename);
+    recordFile(canonicalFilename, filename);
+
+    auto buffer = buffers_->find(canonicalFilename);
+    if (buffer != buffers_->end()) {
+        limits_.checkFileSize(filename, buffer->second.size());
+        inputBytes_ += buffer->second.size();
+        limits_.checkInputBytes(inputBytes_);
+
+        std::string contents = buffer->second;
+        normalizeInput(filename, contents);
+        return contents;
+    }
+
+    if (!std::filesystem::exists(filename)) {
+        throw std::runtime_error("File not found: " + filename);
+    }
+
+    std::error_code ec;
+    auto fileBytes = std::filesystem::file_size(filename, ec);
+    if (!ec) {
+        limits_.checkFileSize(filename, fileBytes);
+        limits_.checkInputBytes(inputBytes_ + fileBytes);
+    }
+
+    std::ifstream file(filename);
+    if (!file.is_open()) {
+        throw std::runtime_error("Could not open file: " + filename);
+    }
+
+    std::string contents((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    inputBytes_ += contents.size();
+    limits_.checkInputBytes(inputBytes_);
+
+    normalizeInput(filename, contents);
+    return contents;
+}
+
+// Notes that a file has been read, for dependencies and the file limit.  When parsing in parallel, the limit
+// applies to the files read by all the parsers together, so it is checked as they go rather than after they
+// have all finished.
+auto Parser::recordFile(const std::filesystem::path& canonicalFilename, const std::string& filename) -> void {
+    if (!processedFiles_.insert(canonicalFilename).second) {
+        return;
+    }
+
+    dependencies_.push_back(filename);
+
+    if (!sharedFiles_) {
+        limits_.checkFileCount(processedFiles_.size());
+        return;
+    }
+
+    size_t files;
+    {
+        std::lock_guard<std::mutex> lock(sharedFiles_->mutex);
+        sharedFiles_->files.insert(canonicalFilename);
+        files = sharedFiles_->files.size();
+    }
+
+    limits_.checkFileCount(files);
+}
+
+// Archives are opened and indexed once per compilation.  The archive, rather than each file read from it, is
+// the dependency, and counts towards the file limit.
+auto Parser::openArchive(const std::string& archiveName) -> const TarArchive& {
+    std::filesystem::path canonicalArchiveName = canonicalPath(archiveName);
+
+    auto& archive = archives_[canonicalArchiveName];
+    if (!archive) {
+        limits_.checkDeadline();
+        recordFile(canonicalArchiveName, archiveName);
+
+        auto buffer = buffers_->find(canonicalArchiveName);
+        if (buffer != buffers_->end()) {
+            archive = std::make_shared<TarArchive>(archiveName, buffer->second);
+        } else {
+            archive = std::make_shared<TarArchive>(archiveName);
+        }
+    }
+
+    return *archive;
+}
+
+// Returns a view of a file inside an archive.  Budgets apply to the file, not to the whole archive.
+auto Parser::loadArchiveMember(const std::string& filename, const std::string& archiveName,
+        const std::string& member) -> std::string_view {
+    const auto& archive = openArchive(archiveName);
 
-    if (processedFiles_.find(canonicalFilename) != processedFiles_.end()) {
-        throw std::runtime_error("'" + filename + "' has already been read");
+    std::string_view contents;
+    if (!archive.find(member, contents)) {
+        throw std::runtime_error("File not found: " + filename);
     }
 
-    processedFiles_.insert(canonicalFilename);
+    limits_.checkDeadline();
+    limits_.checkFileSize(filename, contents.size());
+    inputBytes_ += contents.size();
+    limits_.checkInputBytes(inputBytes_);
+    return contents;
+}
+
+auto Parser::setMinifyMode(MinifyMode minifyMode) -> void {
+    minifyMode_ = minifyMode;
+}
+
+auto Parser::setLimits(const CompileLimits& limits) -> void {
+    limits_ = limits;
+}
+
+auto Parser::setParseThreads(unsigned threads) -> void {
+    parseThreads_ = threads;
+}
+
+auto Parser::setPipelined(bool pipelined) -> void {
+    pipelined_ = pipelined;
+}
+
+auto Parser::setSectionFilter(const SectionFilter& sectionFilter) -> void {
+    sectionFilter_ = sectionFilter;
+}
+
+// When only some sections are compiled, track the section number of each block as the emitter will number it.
+// Included blocks are numbered as children of the block that includes them.
+auto Parser::enterBlock() -> void {
+    if (!sectionFilter_.isActive()) {
+        return;
+    }
+
+    if (blocks_.empty()) {
+        blocks_.push_back({"1", 0});
+        return;
+    }
+
+    auto& parent = blocks_.back();
+    parent.children++;
+    blocks_.push_back({parent.section + "." + std::to_string(parent.children), 0});
+}
+
+auto Parser::leaveBlock() -> void {
+    if (!sectionFilter_.isActive()) {
+        return;
+    }
+
+    blocks_.pop_back();
+}
+
+auto Parser::getDependencies() -> std::vector<std::string> {
+    return dependencies_;
 }
 
-auto Parser::parseInclude() -> void {
+// Returns the first 'Include', in the order they were parsed, that is nested the given number of levels
+// inside an included file's subtree, or nullptr if there isn't one.
+static auto findNestedInclude(const ASTNode& node, size_t depth) -> const ASTNode* {
+    for (const auto& child : node.childNodes_) {
+        if (child->fragment_ && depth == 1) {
+            return child.get();
+        }
+
+        const auto* found = child->fragment_ ? findNestedInclude(*child->fragment_, depth - 1)
+                : findNestedInclude(*child, depth);
+        if (found) {
+            return found;
+        }
+    }
+
+    return nullptr;
+}
+
+// Parses an 'Include' into a node that refers to the subtree for the included file.  Each distinct file is
+// only lexed and parsed once; every other place it is included shares the same subtree.
+auto Parser::parseInclude(const Token& includeToken) -> std::unique_ptr<ASTNode> {
     const auto& token = getNextToken();
     if (token.type != TokenType::KEYWORD_TEXT) {
         raiseSyntaxError(token, "Expected file name for 'Include'");
+        return nullptr;
+    }
+
+    // When only some sections are compiled, an 'Include' that can't affect them is never opened.  That can't
+    // change the numbering of the sections we keep, as anything it adds comes after them.
+    bool filtered = sectionFilter_.isActive();
+    if (filtered && !sectionFilter_.isNeededAfter(blocks_.back().section, blocks_.back().children)) {
+        return nullptr;
+    }
+
+    auto path = canonicalPath(token.value);
+    std::shared_ptr<ASTNode> fragment;
+
+    // The sections that are needed from an included file depend on where it's included, so its subtree can
+    // only be shared when everything is compiled.
+    // A shared subtree brings its own nested includes with it, so the depth limit has to allow for how deep
+    // they go, wherever the file was first included.  If they go too deep, report the 'Include' that parsing
+    // the file again here would have stopped at.
+    size_t depth = includeStack_.size();
+    auto cached = filtered ? fragments_.end() : fragments_.find(path);
+    if (cached != fragments_.end()) {
+        limits_.checkIncludeDepth(token.value, depth);
+        size_t maxDepth = limits_.maxIncludeDepth_;
+        if (maxDepth && depth + cached->second.depth > maxDepth) {
+            const auto* tooDeep = findNestedInclude(*cached->second.node, maxDepth + 1 - depth);
+            limits_.checkIncludeDepth(tooDeep->value_, maxDepth + 1);
+        }
+
+        deepestInclude_ = std::max(deepestInclude_, depth + cached->second.depth);
+        fragment = cached->second.node;
+    } else {
+        if (std::find(includeStack_.begin(), includeStack_.end(), path) != includeStack_.end()) {
+            raiseSyntaxError(token, "Recursive 'Include' of '" + token.value + "'");
+            return nullptr;
+        }
+
+        limits_.checkIncludeDepth(token.value, depth);
+
+        size_t outerDeepest = deepestInclude_;
+        deepestInclude_ = depth;
+        pushLexer(token.value, false);
+        includeStack_.push_back(path);
+        fragment = parseFragment(token);
+        includeStack_.pop_back();
+        lexers_.pop_back();
+        if (!filtered) {
+            fragments_[path] = {fragment, deepestInclude_ - depth};
+        }
+
+        deepestInclude_ = std::max(outerDeepest, deepestInclude_);
+    }
+
+    auto includeNode = std::make_unique<ASTNode>(Token(TokenType::INCLUDE, token.value, includeToken.input,
+            includeToken.filename, includeToken.line, includeToken.column));
+    includeNode->fragment_ = fragment;
+    return includeNode;
+}
+
+// Parses the top level of an included file.  What is valid here depends on where the file is included, so
+// that is checked separately for each 'Include' by checkInclude().
+auto Parser::parseFragment(const Token& filenameToken) -> std::shared_ptr<ASTNode> {
+    auto fragmentNode = std::make_shared<ASTNode>(Token(TokenType::INCLUDE, filenameToken.value, "",
+            std::make_shared<const std::string>(filenameToken.value), 0, 1));
+
+    auto seenTokenType = TokenType::NONE;
+
+    while (true) {
+        const auto& token = getNextToken();
+        switch (token.type) {
+        case TokenType::TEXT:
+            if (seenTokenType != TokenType::NONE) {
+                raiseSyntaxError(token, "Text must come first in an included file");
+            }
+
+            fragmentNode->addChild(parseText(token));
+            break;
+
+        case TokenType::CONTEXT:
+            fragmentNode->addChild(parseContext(token));
+            seenTokenType = TokenType::CONTEXT;
+            break;
+
+        case TokenType::ROLE:
+            fragmentNode->addChild(parseRole(token));
+            seenTokenType = TokenType::ROLE;
+            break;
+
+        case TokenType::INCLUDE:
+            if (auto includeNode = parseInclude(token)) {
+                checkInclude(token, *includeNode, true, true, seenTokenType, "an included file");
+                fragmentNode->addChild(std::move(includeNode));
+            }
+
+            break;
+
+        case TokenType::END_OF_FILE:
+            return fragmentNode;
+
+        default:
+            raiseSyntaxError(token, "Unexpected '" + token.value + "' in included file");
+        }
     }
+}
+
+// Checks that the top-level nodes of an included file are valid in the block where it is included.
+auto Parser::checkInclude(const Token& includeToken, const ASTNode& includeNode, bool allowContext, bool allowRole,
+        TokenType& seenTokenType, const std::string& blockName) -> void {
+    for (const auto& child : includeNode.fragment_->childNodes_) {
+        switch (child->tokenType_) {
+        case TokenType::TEXT:
+            if (seenTokenType != TokenType::NONE) {
+                raiseSyntaxError(includeToken, "Text must come first in " + blockName);
+                return;
+            }
+
+            break;
+
+        case TokenType::CONTEXT:
+        case TokenType::ROLE:
+            if ((child->tokenType_ == TokenType::CONTEXT) ? !allowContext : !allowRole) {
+                raiseSyntaxError(includeToken, "Unexpected '" + child->value_ + "' from 'Include' in " + blockName);
+                return;
+            }
 
-    std::string filename = token.value;
-    loadFile(filename);
-    lexers_.push_back(std::make_unique<MetaphorLexer>(filename));
+            seenTokenType = child->tokenType_;
+            break;
+
+        case TokenType::INCLUDE:
+            checkInclude(includeToken, *child, allowContext, allowRole, seenTokenType, blockName);
+            break;
+
+        default:
+            break;
+        }
+    }
 }
 
 auto Parser::parseEmbed() -> void {
@@ -74,9 +492,32 @@ auto Parser::parseEmbed() -> void {
         raiseSyntaxError(token, "Expected file name for 'Embed'");
     }
 
-    std::string filename = token.value;
-    loadFile(filename);
-    lexers_.push_back(std::make_unique<EmbedLexer>(filename));
+    // Embedded files are only ever text, so they're not needed unless their block is output.
+    if (sectionFilter_.isActive() && (blocks_.empty() || !sectionFilter_.isEmitted(blocks_.back().section))) {
+        return;
+    }
+
+    limits_.checkDeadline();
+
+    // Inside an archive, a wildcard pattern embeds every matching file, in name order.
+    std::string archiveName;
+    std::string member;
+    if (splitArchivePath(token.value, archiveName, member) && member.find_first_of("*?[") != std::string::npos) {
+        auto names = openArchive(archiveName).match(member);
+        if (names.empty()) {
+            raiseSyntaxError(token, "No files in '" + archiveName + "' match '" + member + "'");
+            return;
+        }
+
+        // Lexers are read from the top of the stack, so push the last file first.
+        for (auto name = names.rbegin(); name != names.rend(); ++name) {
+            pushLexer(archiveName + "//" + *name, true);
+        }
+
+        return;
+    }
+
+    pushLexer(token.value, true);
 }
 
 auto Parser::parseKeywordText(const Token& keywordTextToken) -> std::unique_ptr<ASTNode> {
@@ -89,6 +530,7 @@ auto Parser::parseText(const Token& textToken) -> std::unique_ptr<ASTNode> {
 
 auto Parser::parseAction(const Token& actionToken) -> std::unique_ptr<ASTNode> {
     auto actionNode = std::make_unique<ASTNode>(actionToken);
+    enterBlock();
 
     const auto& initToken = getNextToken();
     if (initToken.type == TokenType::KEYWORD_TEXT) {
@@ -102,7 +544,14 @@ auto Parser::parseAction(const Token& actionToken) -> std::unique_ptr<ASTNode> {
     }
 
     auto seenTokenType = TokenType::NONE;
+    parseActionBlocks(*actionNode, seenTokenType);
+    parseActionBody(*actionNode, seenTokenType);
+    leaveBlock();
+    return actionNode;
+}
 
+// Parses the contents of an 'Action' block until its end, returning the type of the last block seen.
+auto Parser::parseActionBody(ASTNode& actionNode, TokenType seenTokenType) -> TokenType {
     while (true) {
         const auto& token = getNextToken();
         switch (token.type) {
@@ -111,17 +560,25 @@ auto Parser::parseAction(const Token& actionToken) -> std::unique_ptr<ASTNode> {
                 raiseSyntaxError(token, "Text must come first in an 'Action' block");
             }
 
-            actionNode->addChild(parseText(token));
+            actionNode.addChild(parseText(token));
             break;
 
         case TokenType::CONTEXT:
-            actionNode->addChild(parseContext(token));
+            actionNode.addChild(parseContext(token));
             seenTokenType = TokenType::CONTEXT;
             break;
 
+        case TokenType::INCLUDE:
+            if (auto includeNode = parseInclude(token)) {
+                checkInclude(token, *includeNode, true, false, seenTokenType, "an 'Action' block");
+                actionNode.addChild(std::move(includeNode));
+            }
+
+            break;
+
         case TokenType::OUTDENT:
         case TokenType::END_OF_FILE:
-            return actionNode;
+            return seenTokenType;
 
         default:
             raiseSyntaxError(token, "Unexpected '" + token.value + "' in 'Action' block");
@@ -129,8 +586,192 @@ auto Parser::parseAction(const Token& actionToken) -> std::unique_ptr<ASTNode> {
     }
 }
 
+// Finds where each top-level 'Context' block starts in the body of an 'Action', using only the INDENT/OUTDENT
+// balance.  end is set to the token that ends the 'Action'.  Returns false if a block isn't opened in the usual
+// way, as the parser's error recovery would then not follow the token balance.
+static auto findTopLevelBlocks(const Lexer& lexer, size_t start, std::vector<size_t>& blockStarts,
+        size_t& end) -> bool {
+    int depth = 0;
+    size_t i = start;
+
+    while (true) {
+        const auto& token = lexer.getToken(i);
+        if (token.type == TokenType::END_OF_FILE) {
+            end = i;
+            return true;
+        }
+
+        if (depth == 0) {
+            if (token.type == TokenType::OUTDENT) {
+                end = i;
+                return true;
+            }
+
+            if (token.type == TokenType::CONTEXT) {
+                blockStarts.push_back(i);
+
+                size_t next = i + 1;
+                if (lexer.getToken(next).type == TokenType::KEYWORD_TEXT) {
+                    next++;
+                }
+
+                if (lexer.getToken(next).type != TokenType::INDENT) {
+                    return false;
+                }
+
+                i = next + 1;
+                depth = 1;
+                continue;
+            }
+        } else if (token.type == TokenType::INDENT) {
+            depth++;
+        } else if (token.type == TokenType::OUTDENT) {
+            depth--;
+        }
+
+        i++;
+    }
+}
+
+// Top-level 'Context' blocks in the root file are independent of each other, so large files are split into
+// runs of blocks that are parsed by separate parsers on their own threads.  The results are then stitched back
+// together, in order, so that the tree, the dependencies and the diagnostics are exactly what a serial parse
+// would produce.  If a run doesn't end where the token balance said it would (which only happens when there
+// are syntax errors) nothing is kept, and the caller parses everything serially instead.
+auto Parser::parseActionBlocks(ASTNode& actionNode, TokenType& seenTokenType) -> void {
+    // Limits on total input can't be checked exactly as each thread reads files independently, and when only
+    // some sections are compiled the blocks have to be numbered in order.
+    if (parseThreads_ == 1 || lexers_.size() != 1 || lexers_.back().stream || limits_.maxInputBytes_ ||
+            sectionFilter_.isActive()) {
+        return;
+    }
+
+    auto& root = lexers_.back();
+    std::vector<size_t> blockStarts;
+    size_t end;
+    if (!findTopLevelBlocks(*root.lexer, root.nextToken, blockStarts, end)) {
+        return;
+    }
+
+    size_t threads = parseThreads_;
+    if (!threads) {
+        threads = std::thread::hardware_concurrency();
+        threads = std::min(threads, (end - root.nextToken) / MIN_TOKENS_PER_THREAD);
+        threads = std::min(threads, blockStarts.size() / MIN_BLOCKS_PER_THREAD);
+    }
+
+    threads = std::min(threads, blockStarts.size());
+    if (threads < 2) {
+        return;
+    }
+
+    // Split into runs with roughly the same number of tokens.  Anything before the first 'Context' goes in
+    // the first run.
+    std::vector<size_t> runStarts = {root.nextToken};
+    for (size_t i = 1; i < threads; i++) {
+        size_t target = root.nextToken + (end - root.nextToken) * i / threads;
+        auto blockStart = std::lower_bound(blockStarts.begin(), blockStarts.end(), target);
+        if (blockStart != blockStarts.end() && *blockStart > runStarts.back()) {
+            runStarts.push_back(*blockStart);
+        }
+    }
+
+    runStarts.push_back(end);
+
+    size_t runs = runStarts.size() - 1;
+    std::vector<std::unique_ptr<Parser>> workers;
+    std::vector<TokenType> seenTokenTypes(runs, TokenType::NONE);
+    std::vector<std::exception_ptr> failures(runs);
+    std::vector<std::thread> workerThreads;
+
+    FileRegistry sharedFiles;
+    sharedFiles.files = processedFiles_;
+
+    for (size_t i = 0; i < runs; i++) {
+        auto worker = std::make_unique<Parser>();
+        worker->buffers_ = buffers_;
+        worker->minifyMode_ = minifyMode_;
+        worker->limits_ = limits_;
+        worker->archives_ = archives_;
+        worker->sharedFiles_ = &sharedFiles;
+        worker->includeStack_.push_back(includeStack_.front());
+        worker->lexers_.push_back({root.lexer, nullptr, runStarts[i], false, runStarts[i + 1]});
+        worker->syntaxTree_ = std::make_unique<ASTNode>(Token(actionNode.tokenType_, actionNode.value_, "",
+                actionNode.filename_, actionNode.line_, actionNode.column_));
+        workers.push_back(std::move(worker));
+    }
+
+    for (size_t i = 0; i < runs; i++) {
+        workerThreads.emplace_back([&, i] {
+            try {
+                auto& worker = *workers[i];
+                seenTokenTypes[i] = worker.parseActionBody(*worker.syntaxTree_, i ? TokenType::NONE : seenTokenType);
+            } catch (...) {
+                failures[i] = std::current_exception();
+            }
+        });
+    }
+
+    for (auto& workerThread : workerThreads) {
+        workerThread.join();
+    }
+
+    // A run matches the serial parse if only the 'Action' level saw the end of its range.  The last run may
+    // end at the real end of the file, which a serial parse also sees at every level.
+    bool endsAtEndOfFile = root.lexer->getToken(end).type == TokenType::END_OF_FILE;
+    for (size_t i = 0; i < runs; i++) {
+        if (failures[i]) {
+            std::rethrow_exception(failures[i]);
+        }
+
+        if (workers[i]->rangeEndReads_ != 1 && !(i == runs - 1 && endsAtEndOfFile)) {
+            return;
+        }
+    }
+
+    const auto& rootFile = includeStack_.front();
+    for (auto& worker : workers) {
+        // A serial parse only parses each included file once, so drop errors from files an earlier run parsed.
+        for (size_t i = 0; i < worker->parseErrors_.size(); i++) {
+            const auto& errorFile = worker->errorFiles_[i];
+            if (errorFile != rootFile && fragments_.count(errorFile)) {
+                continue;
+            }
+
+            parseErrors_.push_back(worker->parseErrors_[i]);
+            errorFiles_.push_back(errorFile);
+        }
+
+        for (const auto& fragment : worker->fragments_) {
+            fragments_.insert(fragment);
+        }
+
+        for (const auto& archive : worker->archives_) {
+            archives_.insert(archive);
+        }
+
+        for (const auto& dependency : worker->dependencies_) {
+            if (processedFiles_.insert(canonicalPath(dependency)).second) {
+                dependencies_.push_back(dependency);
+            }
+        }
+
+        inputBytes_ += worker->inputBytes_;
+
+        for (auto& child : worker->syntaxTree_->childNodes_) {
+            actionNode.addChild(std::move(child));
+        }
+    }
+
+    limits_.checkFileCount(processedFiles_.size());
+
+    seenTokenType = seenTokenTypes.back();
+    root.nextToken = end;
+}
+
 auto Parser::parseContext(const Token& contextToken) -> std::unique_ptr<ASTNode> {
     auto contextNode = std::make_unique<ASTNode>(contextToken);
+    enterBlock();
 
     const auto& initToken = getNextToken();
     if (initToken.type == TokenType::KEYWORD_TEXT) {
@@ -166,8 +807,17 @@ auto Parser::parseContext(const Token& contextToken) -> std::unique_ptr<ASTNode>
             seenTokenType = TokenType::ROLE;
             break;
 
+        case TokenType::INCLUDE:
+            if (auto includeNode = parseInclude(token)) {
+                checkInclude(token, *includeNode, true, true, seenTokenType, "a 'Context' block");
+                contextNode->addChild(std::move(includeNode));
+            }
+
+            break;
+
         case TokenType::OUTDENT:
         case TokenType::END_OF_FILE:
+            leaveBlock();
             return contextNode;
 
         default:
@@ -178,6 +828,7 @@ auto Parser::parseContext(const Token& contextToken) -> std::unique_ptr<ASTNode>
 
 auto Parser::parseRole(const Token& roleToken) -> std::unique_ptr<ASTNode> {
     auto roleNode = std::make_unique<ASTNode>(roleToken);
+    enterBlock();
 
     const auto& initToken = getNextToken();
     if (initToken.type == TokenType::KEYWORD_TEXT) {
@@ -197,8 +848,18 @@ auto Parser::parseRole(const Token& roleToken) -> std::unique_ptr<ASTNode> {
             roleNode->addChild(parseText(token));
             break;
 
+        case TokenType::INCLUDE:
+            if (auto includeNode = parseInclude(token)) {
+                auto seenTokenType = TokenType::NONE;
+                checkInclude(token, *includeNode, false, false, seenTokenType, "a 'Role' block");
+                roleNode->addChild(std::move(includeNode));
+            }
+
+            break;
+
         case TokenType::OUTDENT:
         case TokenType::END_OF_FILE:
+            leaveBlock();
             return roleNode;
 
         default:
@@ -212,8 +873,8 @@ auto Parser::getSyntaxTree() -> std::unique_ptr<ASTNode> {
 }
 
 auto Parser::parse(const std::string& initial_file) -> bool {
-    loadFile(initial_file);
-    lexers_.push_back(std::make_unique<MetaphorLexer>(initial_file));
+    pushLexer(initial_file, false);
+    includeStack_.push_back(canonicalPath(initial_file));
 
     const auto& token = getNextToken();
     if (token.type != TokenType::ACTION) {
@@ -227,6 +888,12 @@ auto Parser::parse(const std::string& initial_file) -> bool {
         raiseSyntaxError(tokenNext, "Unexpected text after 'Action' block");
     }
 
+    // The caches are only needed while parsing.  Release them so the lexed tokens don't stay in memory.
+    lexers_.clear();
+    embedLexers_.clear();
+    fragments_.clear();
+    archives_.clear();
+
     if (parseErrors_.size() > 0) {
         return false;
     }
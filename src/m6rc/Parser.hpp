@@ -5,37 +5,112 @@
 #include <string>
 #include <vector>
 #include <set>
+#include <map>
 #include <memory>
+#include <mutex>
 #include <filesystem>
+#include <cstdint>
 
 #include "Lexer.hpp"
+#include "TokenStream.hpp"
 #include "ASTNode.hpp"
+#include "Minifier.hpp"
+#include "CompileLimits.hpp"
+#include "SectionFilter.hpp"
+#include "TarArchive.hpp"
 
 class Parser {
 public:
     Parser();
+    Parser(const std::map<std::string, std::string>& buffers);
     auto parse(const std::string& initial_file) -> bool;
     auto getSyntaxTree() -> std::unique_ptr<ASTNode>;
     auto getSyntaxErrors() -> std::vector<std::string>;
+    auto getDependencies() -> std::vector<std::string>;
+    auto setMinifyMode(MinifyMode minifyMode) -> void;
+    auto setLimits(const CompileLimits& limits) -> void;
+    auto setParseThreads(unsigned threads) -> void;
+    auto setPipelined(bool pipelined) -> void;
+    auto setSectionFilter(const SectionFilter& sectionFilter) -> void;
 
 private:
+    struct LexerState {
+        std::shared_ptr<Lexer> lexer;   // Lexer holding the tokens for a file
+        std::shared_ptr<TokenStream> stream;
+                                        // If pipelined, the stream to read tokens from instead of the lexer
+        size_t nextToken;               // Index of the next token to read from the lexer
+        bool spliced;                   // Are the tokens spliced into the including file's token stream (Embeds)?
+        size_t endToken = SIZE_MAX;     // Index at which the tokens are treated as ending, when parsing part of a file
+    };
+
+    struct FileRegistry {
+        std::mutex mutex;               // Guards files
+        std::set<std::filesystem::path> files;
+                                        // Files read by any of the parsers working on one compilation
+    };
+
+    struct Fragment {
+        std::shared_ptr<ASTNode> node;  // Subtree for an included file
+        size_t depth;                   // Deepest nesting of 'Include' directives within the file
+    };
+
+    struct BlockState {
+        std::string section;            // Section number of the block
+        int children;                   // Number of child Context and Role blocks seen so far
+    };
+
     auto getNextToken() -> Token;
+    auto enterBlock() -> void;
+    auto leaveBlock() -> void;
+    auto pushLexer(const std::string& filename, bool embed) -> void;
     auto raiseSyntaxError(const Token& token, const std::string& message) -> void;
-    auto loadFile(const std::string& filename) -> void;
-    auto parseInclude() -> void;
+    auto loadFile(const std::string& filename) -> std::string;
+    auto recordFile(const std::filesystem::path& canonicalFilename, const std::string& filename) -> void;
+    auto openArchive(const std::string& archiveName) -> const TarArchive&;
+    auto loadArchiveMember(const std::string& filename, const std::string& archiveName, const std::string& member)
+            -> std::string_view;
+    auto parseInclude(const Token& includeToken) -> std::unique_ptr<ASTNode>;
+    auto parseFragment(const Token& filenameToken) -> std::shared_ptr<ASTNode>;
+    auto checkInclude(const Token& includeToken, const ASTNode& includeNode, bool allowContext, bool allowRole,
+            TokenType& seenTokenType, const std::string& blockName) -> void;
     auto parseEmbed() -> void;
     auto parseKeywordText(const Token& textToken) -> std::unique_ptr<ASTNode>;
     auto parseText(const Token& textToken) -> std::unique_ptr<ASTNode>;
     auto parseAction(const Token& actionToken) -> std::unique_ptr<ASTNode>;
+    auto parseActionBody(ASTNode& actionNode, TokenType seenTokenType) -> TokenType;
+    auto parseActionBlocks(ASTNode& actionNode, TokenType& seenTokenType) -> void;
     auto parseContext(const Token& contextToken) -> std::unique_ptr<ASTNode>;
     auto parseRole(const Token& exampleToken) -> std::unique_ptr<ASTNode>;
 
-    std::vector<std::unique_ptr<Lexer>> lexers_;
-                                        // A vector of lexers currently being used for different files.
+    std::map<std::filesystem::path, std::shared_ptr<TarArchive>> archives_;
+                                        // Archives that files have been read from.  Embed lexers may refer to them.
+    std::vector<LexerState> lexers_;    // A stack of lexers currently being used for different files.
+    std::vector<std::filesystem::path> includeStack_;
+                                        // Files currently being parsed, outermost first, so we can detect recursion.
+    std::map<std::filesystem::path, Fragment> fragments_;
+                                        // Subtrees for files that have already been included.
+    std::map<std::filesystem::path, std::shared_ptr<Lexer>> embedLexers_;
+                                        // Lexers for files that have already been embedded.
     std::set<std::filesystem::path> processedFiles_;
-                                        // A set of files that have already been included so we can avoid recursion.
+                                        // A set of files that have already been read.
+    FileRegistry* sharedFiles_;         // When parsing in parallel, files read by every parser, for the file limit
+    std::shared_ptr<const std::map<std::filesystem::path, std::string>> buffers_;
+                                        // In-memory file contents to use in preference to reading files.
+    std::vector<std::string> dependencies_;
+                                        // All files that have been read, in the order they were first loaded.
+    MinifyMode minifyMode_;             // How embedded files should be minified
+    CompileLimits limits_;              // Resource limits for this compilation
+    size_t inputBytes_;                 // Total number of bytes read so far
+    size_t deepestInclude_;             // Deepest include nesting reached since the current included file started
+    unsigned parseThreads_;             // Number of threads to parse with, or 0 to choose automatically
+    bool pipelined_;                    // Lex each file on its own thread, overlapped with parsing?
+    SectionFilter sectionFilter_;       // Sections to compile
+    std::vector<BlockState> blocks_;    // Blocks currently being parsed, when only some sections are compiled
+    size_t rangeEndReads_;              // Number of times the end of a partial token range has been read
     std::unique_ptr<ASTNode> syntaxTree_;
     std::vector<std::string> parseErrors_;
+    std::vector<std::filesystem::path> errorFiles_;
+                                        // For each syntax error, the file that was being parsed when it was raised
 };
 
 #endif // __PARSER_HPP
@@ -0,0 +1,125 @@
+#include "SectionFilter.hpp"
+
+// Section numbers are one or more positive integers separated by dots.
+auto SectionFilter::isValid(const std::string& section) -> bool {
+    int digits = 0;
+    for (char ch : section) {
+        if (ch == '.') {
+            if (!digits) {
+                return false;
+            }
+
+            digits = 0;
+            continue;
+        }
+
+        if (ch < '0' || ch > '9' || (!digits && ch == '0') || ++digits > 9) {
+            return false;
+        }
+    }
+
+    return digits != 0;
+}
+
+// Is section the same as root, or one of its descendants?
+auto SectionFilter::isWithin(const std::string& section, const std::string& root) -> bool {
+    if (section.compare(0, root.size(), root) != 0) {
+        return false;
+    }
+
+    return section.size() == root.size() || section[root.size()] == '.';
+}
+
+auto SectionFilter::addOnly(const std::string& section) -> bool {
+    if (!isValid(section)) {
+        return false;
+    }
+
+    only_.push_back(section);
+    return true;
+}
+
+auto SectionFilter::addExclude(const std::string& section) -> bool {
+    if (!isValid(section)) {
+        return false;
+    }
+
+    exclude_.push_back(section);
+    return true;
+}
+
+auto SectionFilter::isActive() const -> bool {
+    return !only_.empty() || !exclude_.empty();
+}
+
+auto SectionFilter::isExcluded(const std::string& section) const -> bool {
+    for (const auto& excluded : exclude_) {
+        if (isWithin(section, excluded)) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+// Is the heading and text of a section part of the output?
+auto SectionFilter::isEmitted(const std::string& section) const -> bool {
+    if (isExcluded(section)) {
+        return false;
+    }
+
+    if (only_.empty()) {
+        return true;
+    }
+
+    for (const auto& selected : only_) {
+        if (isWithin(section, selected)) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+// Is a section, or any section inside it, part of the output?
+auto SectionFilter::isVisited(const std::string& section) const -> bool {
+    if (isExcluded(section)) {
+        return false;
+    }
+
+    if (only_.empty()) {
+        return true;
+    }
+
+    for (const auto& selected : only_) {
+        if (isWithin(section, selected) || isWithin(selected, section)) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+// Is anything needed from a section after its first index child sections?  If not, nothing later in the
+// section can change the output, including the numbering of the sections that are output.
+auto SectionFilter::isNeededAfter(const std::string& section, int index) const -> bool {
+    if (isEmitted(section)) {
+        return true;
+    }
+
+    if (isExcluded(section)) {
+        return false;
+    }
+
+    for (const auto& selected : only_) {
+        if (selected.size() <= section.size() || !isWithin(selected, section)) {
+            continue;
+        }
+
+        if (std::stoi(selected.substr(section.size() + 1)) > index) {
+            return true;
+        }
+    }
+
+    return false;
+}
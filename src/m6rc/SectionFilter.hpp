@@ -0,0 +1,28 @@
+#ifndef __SECTIONFILTER_HPP
+#define __SECTIONFILTER_HPP
+
+#include <string>
+#include <vector>
+
+// Selects which numbered sections of a prompt are compiled.  Sections are numbered as they are in the output,
+// for example "1.3.2", and selecting a section also selects everything inside it.
+class SectionFilter {
+public:
+    auto addOnly(const std::string& section) -> bool;
+    auto addExclude(const std::string& section) -> bool;
+    auto isActive() const -> bool;
+    auto isEmitted(const std::string& section) const -> bool;
+    auto isVisited(const std::string& section) const -> bool;
+    auto isNeededAfter(const std::string& section, int index) const -> bool;
+
+private:
+    auto isExcluded(const std::string& section) const -> bool;
+
+    static auto isValid(const std::string& section) -> bool;
+    static auto isWithin(const std::string& section, const std::string& root) -> bool;
+
+    std::vector<std::string> only_;     // Sections to compile, or empty to compile all of them
+    std::vector<std::string> exclude_;  // Sections not to compile
+};
+
+#endif // __SECTIONFILTER_HPP
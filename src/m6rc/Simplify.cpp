@@ -0,0 +1,152 @@
+#include <set>
+
+#include "Simplify.hpp"
+
+// Number of nodes to look at between checks of the compilation deadline.
+#define DEADLINE_CHECK_NODES 4096
+
+struct SimplifyState {
+    std::set<const ASTNode*> simplifiedFragments;
+                                        // Shared subtrees that have already been simplified
+    const CompileLimits* limits;        // Limits whose deadline is checked, or nullptr
+    size_t steps;                       // Number of nodes looked at so far
+};
+
+// Appends a sibling's text to a node's text without building a temporary string.
+static auto appendText(ASTNode& node, char separator, const ASTNode& sibling) -> void {
+    node.value_ += separator;
+    node.value_ += sibling.value_;
+}
+
+// Merging text removes nodes from the child list.  Erasing each one from the vector would make long runs of
+// text, such as large embedded files, quadratic, so surviving children are compacted into place instead.
+// "current" is the child being looked at and "next" is its next surviving sibling.
+static auto simplifyNode(ASTNode& node, SimplifyState& state) -> void {
+    auto& children = node.childNodes_;
+    size_t size = children.size();
+    size_t kept = 0;
+    size_t current = 0;
+    size_t next = 1;
+    bool inFormatedSection = false;
+
+    // Keeps the current child and moves on to its next sibling.
+    auto keepCurrent = [&]() {
+        if (current < size) {
+            if (kept != current) {
+                children[kept] = std::move(children[current]);
+            }
+
+            kept++;
+        }
+
+        current = next;
+        next = current + 1;
+    };
+
+    auto removeCurrent = [&]() {
+        children[current].reset();
+        current = next;
+        next = current + 1;
+    };
+
+    auto removeNext = [&]() {
+        children[next].reset();
+        next++;
+    };
+
+    while (current < size) {
+        if (state.limits && ++state.steps % DEADLINE_CHECK_NODES == 0) {
+            state.limits->checkDeadline();
+        }
+
+        auto& child = children[current];
+
+        // Included subtrees are shared, so make sure we only simplify each of them once.
+        if (child->tokenType_ == TokenType::INCLUDE) {
+            if (state.simplifiedFragments.insert(child->fragment_.get()).second) {
+                simplifyNode(*child->fragment_, state);
+            }
+
+            keepCurrent();
+            continue;
+        }
+
+        // If we have anything other than a text node then simply recurse.
+        if (child->tokenType_ != TokenType::TEXT) {
+            simplifyNode(*child, state);
+            keepCurrent();
+            continue;
+        }
+
+        // If we're not processing a formatted text block then any blank lines we encounter here
+        // can just be eaten!  The node after a blank line is kept as it is.
+        if (!inFormatedSection) {
+            if (child->value_.length() == 0) {
+                removeCurrent();
+                keepCurrent();
+                continue;
+            }
+        }
+
+        // We have a text node.  If we don't have a sibling then we can't look to merge anything.
+        if (next >= size) {
+            keepCurrent();
+            continue;
+        }
+
+        // Do we have a formatted code delimeter?  If yes then track that.
+        if (child->value_.compare(0, 3, "```") == 0) {
+            inFormatedSection = true;
+        }
+
+        // If our sibling isn't a text node we can't merge it.
+        auto& sibling = children[next];
+        if (sibling->tokenType_ != TokenType::TEXT) {
+            inFormatedSection = false;
+            keepCurrent();
+            continue;
+        }
+
+        // Is our sibling a formatted code delimeter?
+        if (sibling->value_.compare(0, 3, "```") == 0) {
+            // If we're in a formatted section then this is ending that block.  The node after it is kept as
+            // it is.
+            if (inFormatedSection) {
+                appendText(*child, '\n', *sibling);
+                removeNext();
+                keepCurrent();
+                keepCurrent();
+                inFormatedSection = false;
+                continue;
+            }
+
+            // We're going to start a new formatted block.
+            keepCurrent();
+            continue;
+        }
+
+        // If we're in a formatted text section then apply a newline and merge these two elements.
+        if (inFormatedSection) {
+            appendText(*child, '\n', *sibling);
+            removeNext();
+            continue;
+        }
+
+        // If our next text is an empty line then this indicates the end of a paragraph.
+        if (sibling->value_.length() == 0) {
+            removeNext();
+            keepCurrent();
+            continue;
+        }
+
+        appendText(*child, ' ', *sibling);
+        removeNext();
+    }
+
+    children.resize(kept);
+}
+
+auto simplifyText(ASTNode& node, const CompileLimits* limits) -> void {
+    SimplifyState state = {{}, limits, 0};
+    simplifyNode(node, state);
+}
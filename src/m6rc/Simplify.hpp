@@ -0,0 +1,11 @@
+#ifndef __SIMPLIFY_HPP
+#define __SIMPLIFY_HPP
+
+#include "ASTNode.hpp"
+#include "CompileLimits.hpp"
+
+// Merge adjacent text nodes into paragraphs and formatted blocks, and drop blank lines that aren't needed.
+// If limits are given, their deadline is checked as the tree is walked.
+auto simplifyText(ASTNode& node, const CompileLimits* limits = nullptr) -> void;
+
+#endif // __SIMPLIFY_HPP
@@ -0,0 +1,143 @@
+#include <algorithm>
+#include <array>
+#include <iomanip>
+
+#include "SizeReport.hpp"
+
+enum CharClass : unsigned char {
+    ALPHA,
+    DIGIT,
+    SPACE,
+    NEWLINE,
+    PUNCT,
+    UTF8_LEAD,
+    UTF8_CONTINUATION
+};
+
+// Build a table mapping every byte to its character class so the estimator is a single table lookup per byte.
+static auto buildCharClasses() -> std::array<CharClass, 256> {
+    std::array<CharClass, 256> classes;
+    for (int i = 0; i < 256; i++) {
+        if ((i >= 'a' && i <= 'z') || (i >= 'A' && i <= 'Z')) {
+            classes[i] = ALPHA;
+        } else if (i >= '0' && i <= '9') {
+            classes[i] = DIGIT;
+        } else if (i == ' ' || i == '\t') {
+            classes[i] = SPACE;
+        } else if (i == '\n' || i == '\r') {
+            classes[i] = NEWLINE;
+        } else if (i >= 0xc0) {
+            classes[i] = UTF8_LEAD;
+        } else if (i >= 0x80) {
+            classes[i] = UTF8_CONTINUATION;
+        } else {
+            classes[i] = PUNCT;
+        }
+    }
+
+    return classes;
+}
+
+SizeReport::SizeReport() :
+        total_{0, 0} {
+}
+
+// Estimate the number of tokens a BPE tokenizer would produce for some text.  This mirrors how BPE
+// vocabularies typically split text: a single space merges with the word that follows it, common words are
+// one token and long words are split into chunks of around 6 letters, numbers are split into groups of 3
+// digits, runs of newlines or indentation become single tokens, and punctuation and non-ASCII characters are
+// usually a token each.  It is intended to be cheap enough to run on every build, not to be exact.
+auto SizeReport::estimateTokens(const std::string& text) -> size_t {
+    static const auto classes = buildCharClasses();
+
+    size_t tokens = 0;
+    size_t i = 0;
+    size_t size = text.size();
+    while (i < size) {
+        auto cls = classes[static_cast<unsigned char>(text[i])];
+        size_t start = i++;
+        while (i < size && classes[static_cast<unsigned char>(text[i])] == cls) {
+            i++;
+        }
+
+        size_t length = i - start;
+        switch (cls) {
+        case ALPHA:
+            tokens += (length + 5) / 6;
+            break;
+
+        case DIGIT:
+            tokens += (length + 2) / 3;
+            break;
+
+        case SPACE:
+            // A single space is absorbed by the next word.  Longer runs are typically one token per 16 characters.
+            if (length > 1) {
+                tokens += (length + 15) / 16;
+            }
+
+            break;
+
+        case NEWLINE:
+            tokens++;
+            break;
+
+        case PUNCT:
+        case UTF8_LEAD:
+            tokens += length;
+            break;
+
+        case UTF8_CONTINUATION:
+            break;
+        }
+    }
+
+    return tokens;
+}
+
+auto SizeReport::add(const std::string& section, const std::string& filename, const std::string& text,
+        size_t overheadBytes) -> void {
+    // Overhead bytes are separators (spaces and newlines) that BPE tokenizers fold into neighbouring tokens.
+    size_t bytes = text.size() + overheadBytes;
+    size_t tokens = estimateTokens(text);
+
+    if (sections_.empty() || sections_.back().first != section) {
+        sections_.push_back({section, {0, 0}});
+    }
+
+    auto& sectionSize = sections_.back().second;
+    sectionSize.bytes += bytes;
+    sectionSize.tokens += tokens;
+
+    auto& fileSize = files_[filename];
+    fileSize.bytes += bytes;
+    fileSize.tokens += tokens;
+
+    total_.bytes += bytes;
+    total_.tokens += tokens;
+}
+
+auto SizeReport::print(std::ostream& out, size_t maxFiles) const -> void {
+    out << "Section sizes:\n";
+    out << std::setw(12) << "bytes" << std::setw(12) << "~tokens" << "  section\n";
+    for (const auto& [section, size] : sections_) {
+        out << std::setw(12) << size.bytes << std::setw(12) << size.tokens << "  " << section << "\n";
+    }
+
+    out << std::setw(12) << total_.bytes << std::setw(12) << total_.tokens << "  total\n";
+
+    std::vector<std::pair<std::string, Size>> files(files_.begin(), files_.end());
+    std::stable_sort(files.begin(), files.end(), [](const auto& a, const auto& b) {
+        return a.second.tokens > b.second.tokens;
+    });
+
+    if (files.size() > maxFiles) {
+        files.resize(maxFiles);
+    }
+
+    out << "\nLargest contributing files:\n";
+    out << std::setw(12) << "bytes" << std::setw(12) << "~tokens" << "  file\n";
+    for (const auto& [filename, size] : files) {
+        out << std::setw(12) << size.bytes << std::setw(12) << size.tokens << "  " << filename << "\n";
+    }
+}
@@ -0,0 +1,33 @@
+#ifndef __SIZEREPORT_HPP
+#define __SIZEREPORT_HPP
+
+#include <string>
+#include <vector>
+#include <map>
+#include <ostream>
+
+// Tracks how many output bytes and estimated LLM tokens each section, and each contributing file, is
+// responsible for.
+class SizeReport {
+public:
+    SizeReport();
+
+    auto add(const std::string& section, const std::string& filename, const std::string& text,
+            size_t overheadBytes) -> void;
+    auto print(std::ostream& out, size_t maxFiles = 10) const -> void;
+
+    static auto estimateTokens(const std::string& text) -> size_t;
+
+private:
+    struct Size {
+        size_t bytes;
+        size_t tokens;
+    };
+
+    std::vector<std::pair<std::string, Size>> sections_;
+                                        // Sizes of each section, in output order
+    std::map<std::string, Size> files_; // Sizes attributed to each contributing file
+    Size total_;                        // Total size of the output
+};
+
+#endif // __SIZEREPORT_HPP
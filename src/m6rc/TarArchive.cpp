@@ -0,0 +1,306 @@
+#include <cerrno>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <optional>
+
+#include <fcntl.h>
+#include <fnmatch.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "TarArchive.hpp"
+
+#define BLOCK_SIZE 512
+
+// Offsets and sizes of the header fields we need.
+#define NAME_OFFSET 0
+#define NAME_SIZE 100
+#define SIZE_OFFSET 124
+#define SIZE_SIZE 12
+#define CHECKSUM_OFFSET 148
+#define CHECKSUM_SIZE 8
+#define TYPE_OFFSET 156
+#define MAGIC_OFFSET 257
+#define PREFIX_OFFSET 345
+#define PREFIX_SIZE 155
+
+TarArchive::TarArchive(const std::string& filename) :
+        filename_(filename),
+        mapping_(nullptr),
+        mappingSize_(0),
+        data_(""),
+        size_(0) {
+    int fd = open(filename.c_str(), O_RDONLY);
+    if (fd < 0) {
+        throw std::runtime_error((errno == ENOENT ? "File not found: " : "Could not open file: ") + filename);
+    }
+
+    struct stat status;
+    if (fstat(fd, &status) < 0) {
+        close(fd);
+        throw std::runtime_error("Could not open file: " + filename);
+    }
+
+    if (status.st_size > 0) {
+        mappingSize_ = static_cast<size_t>(status.st_size);
+        mapping_ = mmap(nullptr, mappingSize_, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (mapping_ == MAP_FAILED) {
+            mapping_ = nullptr;
+            close(fd);
+            throw std::runtime_error("Could not map file: " + filename);
+        }
+
+        data_ = static_cast<const char*>(mapping_);
+        size_ = mappingSize_;
+    }
+
+    close(fd);
+
+    try {
+        buildIndex();
+    } catch (...) {
+        if (mapping_) {
+            munmap(mapping_, mappingSize_);
+        }
+
+        throw;
+    }
+}
+
+TarArchive::TarArchive(const std::string& filename, std::string contents) :
+        filename_(filename),
+        contents_(std::move(contents)),
+        mapping_(nullptr),
+        mappingSize_(0),
+        data_(contents_.data()),
+        size_(contents_.size()) {
+    buildIndex();
+}
+
+TarArchive::~TarArchive() {
+    if (mapping_) {
+        munmap(mapping_, mappingSize_);
+    }
+}
+
+// Looks up a regular file in the archive, returning a view of its contents.
+auto TarArchive::find(const std::string& member, std::string_view& contents) const -> bool {
+    auto entry = members_.find(normalizeName(member));
+    if (entry == members_.end()) {
+        return false;
+    }
+
+    contents = std::string_view(data_ + entry->second.offset, entry->second.size);
+    return true;
+}
+
+// Returns the names of all the regular files matching a shell wildcard pattern, in sorted order.  As with
+// shell globs, wildcards don't match across '/' characters.
+auto TarArchive::match(const std::string& pattern) const -> std::vector<std::string> {
+    std::string normalizedPattern = normalizeName(pattern);
+
+    std::vector<std::string> names;
+    for (const auto& [name, member] : members_) {
+        if (fnmatch(normalizedPattern.c_str(), name.c_str(), FNM_PATHNAME) == 0) {
+            names.push_back(name);
+        }
+    }
+
+    return names;
+}
+
+// Archives made with "tar cf archive.tar ." name everything "./...", so those prefixes are ignored.
+auto TarArchive::normalizeName(std::string name) -> std::string {
+    size_t start = 0;
+    while (name.compare(start, 2, "./") == 0) {
+        start += 2;
+    }
+
+    return name.substr(start);
+}
+
+auto TarArchive::corrupt() const -> std::runtime_error {
+    return std::runtime_error("Invalid tar archive: " + filename_);
+}
+
+// Numeric fields are normally octal text, but large values use a base-256 encoding flagged by the top bit.
+static auto parseNumber(const char* field, size_t size) -> std::optional<uint64_t> {
+    uint64_t value = 0;
+    if (static_cast<unsigned char>(field[0]) & 0x80) {
+        if (static_cast<unsigned char>(field[0]) != 0x80) {
+            return std::nullopt;
+        }
+
+        for (size_t i = 1; i < size; i++) {
+            if (value >> 56) {
+                return std::nullopt;
+            }
+
+            value = (value << 8) | static_cast<unsigned char>(field[i]);
+        }
+
+        return value;
+    }
+
+    size_t i = 0;
+    while (i < size && field[i] == ' ') {
+        i++;
+    }
+
+    for (; i < size && field[i] >= '0' && field[i] <= '7'; i++) {
+        value = (value << 3) | static_cast<uint64_t>(field[i] - '0');
+    }
+
+    if (i < size && field[i] != ' ' && field[i] != '\0') {
+        return std::nullopt;
+    }
+
+    return value;
+}
+
+// The checksum is the sum of the header bytes, with the checksum field itself counted as spaces.  Some old
+// archivers summed signed bytes, so accept either.
+static auto isValidHeader(const char* header) -> bool {
+    auto stored = parseNumber(header + CHECKSUM_OFFSET, CHECKSUM_SIZE);
+    if (!stored) {
+        return false;
+    }
+
+    int64_t unsignedSum = 0;
+    int64_t signedSum = 0;
+    for (size_t i = 0; i < BLOCK_SIZE; i++) {
+        bool isChecksum = i >= CHECKSUM_OFFSET && i < CHECKSUM_OFFSET + CHECKSUM_SIZE;
+        unsignedSum += isChecksum ? ' ' : static_cast<unsigned char>(header[i]);
+        signedSum += isChecksum ? ' ' : static_cast<signed char>(header[i]);
+    }
+
+    return static_cast<int64_t>(*stored) == unsignedSum || static_cast<int64_t>(*stored) == signedSum;
+}
+
+static auto isZeroBlock(const char* block) -> bool {
+    for (size_t i = 0; i < BLOCK_SIZE; i++) {
+        if (block[i]) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+// Fields are NUL terminated unless they fill all the space available.
+static auto fieldString(const char* field, size_t size) -> std::string {
+    return std::string(field, strnlen(field, size));
+}
+
+// Walks the headers once, recording where each regular file's contents are.  GNU long names and pax extended
+// headers describe the entry that follows them.  If a name appears more than once, the last one wins, just as
+// it would on extraction.
+auto TarArchive::buildIndex() -> void {
+    std::optional<std::string> nextName;
+    bool hasNextSize = false;
+    uint64_t nextSize = 0;
+
+    size_t offset = 0;
+    while (offset + BLOCK_SIZE <= size_) {
+        const char* header = data_ + offset;
+        if (isZeroBlock(header)) {
+            break;
+        }
+
+        if (!isValidHeader(header)) {
+            throw corrupt();
+        }
+
+        auto headerSize = parseNumber(header + SIZE_OFFSET, SIZE_SIZE);
+        if (!headerSize) {
+            throw corrupt();
+        }
+
+        // Extension headers carry their own size, but a pax size overrides the size of the entry that follows.
+        char type = header[TYPE_OFFSET];
+        bool isExtension = type == 'x' || type == 'g' || type == 'L' || type == 'K';
+        uint64_t size = (hasNextSize && !isExtension) ? nextSize : *headerSize;
+        size_t dataOffset = offset + BLOCK_SIZE;
+        if (size > size_ - dataOffset) {
+            throw corrupt();
+        }
+
+        const char* data = data_ + dataOffset;
+        switch (type) {
+        case 'L':
+            nextName = fieldString(data, size);
+            break;
+
+        case 'x': {
+            // Each record is "<length> <key>=<value>\n", where the length includes the whole record.
+            size_t i = 0;
+            while (i < size) {
+                size_t space = i;
+                while (space < size && data[space] != ' ') {
+                    space++;
+                }
+
+                size_t length = 0;
+                for (size_t j = i; j < space; j++) {
+                    if (data[j] < '0' || data[j] > '9') {
+                        throw corrupt();
+                    }
+
+                    length = length * 10 + static_cast<size_t>(data[j] - '0');
+                    if (length > size) {
+                        throw corrupt();
+                    }
+                }
+
+                if (space >= size || length <= space - i + 1 || length > size - i) {
+                    throw corrupt();
+                }
+
+                std::string record(data + space + 1, length - (space - i) - 2);
+                auto equals = record.find('=');
+                if (equals != std::string::npos) {
+                    auto key = record.substr(0, equals);
+                    auto value = record.substr(equals + 1);
+                    if (key == "path") {
+                        nextName = value;
+                    } else if (key == "size") {
+                        nextSize = std::strtoull(value.c_str(), nullptr, 10);
+                        hasNextSize = true;
+                    }
+                }
+
+                i += length;
+            }
+
+            break;
+        }
+
+        case 'g':
+        case 'K':
+            break;
+
+        default:
+            if (type == '0' || type == '\0' || type == '7') {
+                std::string name;
+                if (nextName) {
+                    name = *nextName;
+                } else {
+                    name = fieldString(header + NAME_OFFSET, NAME_SIZE);
+                    if (memcmp(header + MAGIC_OFFSET, "ustar\0", 6) == 0 && header[PREFIX_OFFSET]) {
+                        name = fieldString(header + PREFIX_OFFSET, PREFIX_SIZE) + "/" + name;
+                    }
+                }
+
+                members_[normalizeName(name)] = {dataOffset, static_cast<size_t>(size)};
+            }
+
+            nextName.reset();
+            hasNextSize = false;
+            break;
+        }
+
+        offset = dataOffset + ((size + BLOCK_SIZE - 1) / BLOCK_SIZE) * BLOCK_SIZE;
+    }
+}
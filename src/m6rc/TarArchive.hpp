@@ -0,0 +1,46 @@
+#ifndef __TARARCHIVE_HPP
+#define __TARARCHIVE_HPP
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <map>
+#include <stdexcept>
+
+// Read-only view of a tar archive.  The archive is mapped into memory and its headers are indexed once, after
+// which member contents are returned as views straight into the mapping.  ustar, GNU long name and pax path
+// headers are understood; anything other than regular files is ignored.
+class TarArchive {
+public:
+    TarArchive(const std::string& filename);
+    TarArchive(const std::string& filename, std::string contents);
+    ~TarArchive();
+
+    TarArchive(const TarArchive&) = delete;
+    auto operator=(const TarArchive&) -> TarArchive& = delete;
+
+    auto find(const std::string& member, std::string_view& contents) const -> bool;
+    auto match(const std::string& pattern) const -> std::vector<std::string>;
+
+    static auto normalizeName(std::string name) -> std::string;
+
+private:
+    struct Member {
+        size_t offset;                  // Offset of the member's contents within the archive
+        size_t size;                    // Size of the member's contents
+    };
+
+    auto buildIndex() -> void;
+    auto corrupt() const -> std::runtime_error;
+
+    std::string filename_;              // Archive file name, for error messages
+    std::string contents_;              // Archive contents, if they were supplied in memory
+    void* mapping_;                     // Mapped archive, if it was read from a file
+    size_t mappingSize_;                // Size of the mapping
+    const char* data_;                  // Start of the archive
+    size_t size_;                       // Size of the archive
+    std::map<std::string, Member> members_;
+                                        // Regular files in the archive, by name
+};
+
+#endif // __TARARCHIVE_HPP
@@ -2,6 +2,7 @@
 #define __TOKEN_HPP
 
 #include <string>
+#include <memory>
 #include <ostream>
 
 enum class TokenType {
@@ -22,8 +23,10 @@ enum class TokenType {
 
 class Token {
 public:
-    Token(TokenType type, std::string value, std::string input, std::string filename, int line, int column)
-            : type(type), value(std::move(value)), input(input), filename(filename), line(line), column(column) {
+    Token(TokenType type, std::string value, std::string input, std::shared_ptr<const std::string> filename,
+            int line, int column)
+            : type(type), value(std::move(value)), input(input), filename(std::move(filename)), line(line),
+            column(column) {
     }
 
     friend std::ostream& operator<<(std::ostream& os, const Token& token) {
@@ -36,7 +39,8 @@ public:
     TokenType type;
     std::string value;
     std::string input;
-    std::string filename;
+    std::shared_ptr<const std::string> filename;
+                                        // Shared by every token and AST node from the same file
     int line;
     int column;
 };
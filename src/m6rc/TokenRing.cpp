@@ -0,0 +1,95 @@
+#include <thread>
+
+#include "TokenRing.hpp"
+
+// Number of times to poll, and then to yield the CPU, before sleeping while waiting for the other thread.
+#define SPIN_LIMIT 64
+#define YIELD_LIMIT 256
+
+TokenRing::TokenRing(size_t capacity) :
+        head_(0),
+        tail_(0),
+        cancelled_(false),
+        producerWaiting_(false),
+        consumerWaiting_(false) {
+    size_t size = 2;
+    while (size < capacity) {
+        size <<= 1;
+    }
+
+    slots_.resize(size);
+    mask_ = size - 1;
+}
+
+// Waits until ready() returns true.  The other thread usually catches up quickly, so start by polling, then
+// yield for a while, and only then go to sleep.  A thread that is stalled, for example on slow I/O, doesn't
+// keep a core busy.
+template <typename Ready>
+auto TokenRing::waitFor(std::atomic<bool>& waiting, Ready ready) -> void {
+    for (int spins = 0; spins < SPIN_LIMIT + YIELD_LIMIT; spins++) {
+        if (ready()) {
+            return;
+        }
+
+        if (spins >= SPIN_LIMIT) {
+            std::this_thread::yield();
+        }
+    }
+
+    // The fence pairs with the one in wake(): either we see the other thread's update, or it sees that we are
+    // waiting and wakes us.
+    std::unique_lock<std::mutex> lock(mutex_);
+    waiting.store(true, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    while (!ready()) {
+        wakeup_.wait(lock);
+    }
+
+    waiting.store(false, std::memory_order_relaxed);
+}
+
+// Wakes the other thread if it has gone to sleep in waitFor().
+auto TokenRing::wake(std::atomic<bool>& waiting) -> void {
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (waiting.load(std::memory_order_relaxed)) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        wakeup_.notify_all();
+    }
+}
+
+auto TokenRing::push(Token token) -> void {
+    size_t head = head_.load(std::memory_order_relaxed);
+
+    waitFor(producerWaiting_, [&] {
+        return cancelled_.load(std::memory_order_relaxed) || head - tail_.load(std::memory_order_acquire) <= mask_;
+    });
+
+    if (cancelled_.load(std::memory_order_relaxed)) {
+        return;
+    }
+
+    slots_[head & mask_].emplace(std::move(token));
+    head_.store(head + 1, std::memory_order_release);
+    wake(consumerWaiting_);
+}
+
+auto TokenRing::pop() -> Token {
+    size_t tail = tail_.load(std::memory_order_relaxed);
+
+    waitFor(consumerWaiting_, [&] {
+        return head_.load(std::memory_order_acquire) != tail;
+    });
+
+    auto& slot = slots_[tail & mask_];
+    Token token = std::move(*slot);
+    slot.reset();
+    tail_.store(tail + 1, std::memory_order_release);
+    wake(producerWaiting_);
+    return token;
+}
+
+// Stop the producer waiting for space, so it can run to completion even though nothing will read its tokens.
+auto TokenRing::cancel() -> void {
+    cancelled_.store(true, std::memory_order_relaxed);
+    wake(producerWaiting_);
+}
@@ -0,0 +1,43 @@
+#ifndef __TOKENRING_HPP
+#define __TOKENRING_HPP
+
+#include <vector>
+#include <optional>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+
+#include "Token.hpp"
+
+// A bounded, lock-free, ring buffer that passes tokens from one producer thread to one consumer thread.  The
+// producer waits while the ring is full, so the number of tokens in flight never exceeds its capacity.  A
+// thread that has to wait for long sleeps on a condition variable; the lock is only taken to sleep or wake.
+class TokenRing {
+public:
+    TokenRing(size_t capacity);
+
+    auto push(Token token) -> void;
+    auto pop() -> Token;
+    auto cancel() -> void;
+
+private:
+    template <typename Ready>
+    auto waitFor(std::atomic<bool>& waiting, Ready ready) -> void;
+    auto wake(std::atomic<bool>& waiting) -> void;
+
+    std::vector<std::optional<Token>> slots_;
+                                        // Storage for tokens in flight
+    size_t mask_;                       // Capacity - 1, used to wrap indices (the capacity is a power of 2)
+    alignas(64) std::atomic<size_t> head_;
+                                        // Number of tokens pushed, only written by the producer
+    alignas(64) std::atomic<size_t> tail_;
+                                        // Number of tokens popped, only written by the consumer
+    alignas(64) std::atomic<bool> cancelled_;
+                                        // Set when the consumer no longer wants any more tokens
+    std::atomic<bool> producerWaiting_; // Is the producer asleep waiting for space?
+    std::atomic<bool> consumerWaiting_; // Is the consumer asleep waiting for a token?
+    std::mutex mutex_;                  // Held while going to sleep or waking the other thread
+    std::condition_variable wakeup_;    // Signalled when a sleeping thread may be able to continue
+};
+
+#endif // __TOKENRING_HPP
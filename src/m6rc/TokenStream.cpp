@@ -0,0 +1,46 @@
+#include "TokenStream.hpp"
+#include "EmbedLexer.hpp"
+#include "MetaphorLexer.hpp"
+
+// The limits are only read, so they can be shared with the lexer thread.
+TokenStream::TokenStream(const std::string& filename, std::string input, bool embed, MinifyMode minifyMode,
+        size_t ringSize, const CompileLimits* limits) :
+        ring_(ringSize) {
+    thread_ = std::thread([this, filename, input = std::move(input), embed, minifyMode, limits]() mutable {
+        try {
+            if (embed) {
+                EmbedLexer lexer(filename, std::move(input), minifyMode, &ring_, limits);
+            } else {
+                MetaphorLexer lexer(filename, std::move(input), &ring_, limits);
+            }
+        } catch (...) {
+            failure_ = std::current_exception();
+            ring_.push(Token(TokenType::END_OF_FILE, "", "", std::make_shared<const std::string>(filename), 0, 1));
+        }
+    });
+}
+
+TokenStream::~TokenStream() {
+    ring_.cancel();
+    thread_.join();
+}
+
+// Returns the next token without consuming it.  Once the end of the file is reached, this keeps returning the
+// END_OF_FILE token.
+auto TokenStream::peek() -> const Token& {
+    if (!next_) {
+        next_.emplace(ring_.pop());
+        if (next_->type == TokenType::END_OF_FILE && failure_) {
+            std::rethrow_exception(failure_);
+        }
+    }
+
+    return *next_;
+}
+
+auto TokenStream::take() -> Token {
+    peek();
+    Token token = std::move(*next_);
+    next_.reset();
+    return token;
+}
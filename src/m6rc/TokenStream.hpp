@@ -0,0 +1,31 @@
+#ifndef __TOKENSTREAM_HPP
+#define __TOKENSTREAM_HPP
+
+#include <string>
+#include <thread>
+#include <optional>
+#include <exception>
+
+#include "TokenRing.hpp"
+#include "Minifier.hpp"
+#include "CompileLimits.hpp"
+
+// Lexes a file on its own thread while the parser consumes its tokens.  Tokens are handed over through a
+// TokenRing, so lexing runs ahead of parsing by at most the size of the ring.
+class TokenStream {
+public:
+    TokenStream(const std::string& filename, std::string input, bool embed, MinifyMode minifyMode,
+            size_t ringSize, const CompileLimits* limits = nullptr);
+    ~TokenStream();
+
+    auto peek() -> const Token&;
+    auto take() -> Token;
+
+private:
+    TokenRing ring_;                    // Tokens passed from the lexer thread
+    std::optional<Token> next_;         // Token that has been read from the ring but not yet taken
+    std::exception_ptr failure_;        // Exception thrown by the lexer, if any
+    std::thread thread_;                // Thread running the lexer
+};
+
+#endif // __TOKENSTREAM_HPP
@@ -0,0 +1,17 @@
+#ifndef __WORDSCAN_HPP
+#define __WORDSCAN_HPP
+
+#include <cstdint>
+
+// Helpers for scanning text 8 bytes at a time, so runs of bytes that need no attention can be skipped a word
+// at a time rather than a byte at a time.
+
+constexpr uint64_t ONES = 0x0101010101010101ULL;
+constexpr uint64_t HIGHS = 0x8080808080808080ULL;
+
+// Returns non-zero if any byte in the word is zero.
+inline auto hasZeroByte(uint64_t word) -> uint64_t {
+    return (word - ONES) & ~word & HIGHS;
+}
+
+#endif // __WORDSCAN_HPP
@@ -1,10 +1,71 @@
 #include <iostream>
+#include <algorithm>
 #include <fstream>
 #include <string>
 #include <stdexcept>
 #include <filesystem>
+#include <thread>
 #include <getopt.h>
 #include "Parser.hpp"
+#include "Simplify.hpp"
+#include "Emitter.hpp"
+#include "JsonEmitter.hpp"
+#include "DependencyFile.hpp"
+
+#define OPT_JSON_SECTIONS 256
+#define OPT_MD 257
+#define OPT_MF 258
+#define OPT_MP 259
+#define OPT_MT 260
+#define OPT_SIZE_REPORT 261
+#define OPT_MINIFY_EMBEDS 262
+#define OPT_STRIP_LICENSES 263
+#define OPT_MAX_INPUT_BYTES 264
+#define OPT_MAX_FILE_BYTES 265
+#define OPT_MAX_INCLUDE_DEPTH 266
+#define OPT_MAX_FILES 267
+#define OPT_MAX_OUTPUT_BYTES 268
+#define OPT_TIMEOUT 269
+#define OPT_PARSE_THREADS 270
+#define OPT_PIPELINE 271
+#define OPT_ONLY 272
+#define OPT_EXCLUDE 273
+
+// Most parse threads used for each CPU core.  Beyond this, threads only add overhead, so larger requests are
+// quietly reduced.  The output never depends on the number of threads.
+#define MAX_PARSE_THREADS_PER_CORE 4
+
+// Most parse threads that can be asked for on any machine.  Anything larger is almost certainly a mistake.
+#define MAX_PARSE_THREADS 1024
+
+// Parse a numeric option value, rejecting anything that isn't a plain non-negative integer.
+static auto parseLimit(const char* option, const char* value, size_t& limit) -> bool {
+    std::string text(value);
+    if (text.empty() || text.find_first_not_of("0123456789") != std::string::npos) {
+        std::cerr << "Error: " << option << " requires a non-negative integer, not '" << text << "'.\n";
+        return false;
+    }
+
+    try {
+        limit = std::stoull(text);
+    } catch (const std::out_of_range&) {
+        std::cerr << "Error: " << option << " value '" << text << "' is too large.\n";
+        return false;
+    }
+
+    return true;
+}
+
+// Don't leave a partial prompt behind if compilation is abandoned part way through.
+static auto removeOutputFile(std::ofstream& outFile, const std::string& outputFile) -> void {
+    if (outputFile.empty()) {
+        return;
+    }
+
+    outFile.close();
+    std::error_code ec;
+    std::filesystem::remove(outputFile, ec);
+}
 
 void printUsage(const char* programName) {
     std::cerr << "Usage: " << programName << " [options] <file>\n"
@@ -12,150 +73,188 @@ void printUsage(const char* programName) {
         << "  -h, --help                Print this help message\n"
         << "  -o, --outputFile <file>   Specify output file\n"
         << "  -d, --debug               Generate debug output\n"
+        << "  -f, --format <format>     Output format: text (default), json or jsonl\n"
+        << "      --json-sections       Emit section headings as structured JSON fields\n"
+        << "      --minify-embeds       Strip comments and blank line runs from embedded files\n"
+        << "      --strip-licenses      Strip leading license comments from embedded files\n"
+        << "      --size-report         Print output bytes and estimated tokens per section and file to stderr\n"
+        << "      --max-input-bytes <n> Stop if the total size of all files read exceeds <n> bytes\n"
+        << "      --max-file-bytes <n>  Stop if any one file is larger than <n> bytes\n"
+        << "      --max-include-depth <n>\n"
+        << "                            Stop if 'Include' directives are nested more than <n> deep\n"
+        << "      --max-files <n>       Stop if more than <n> distinct files are read\n"
+        << "      --max-output-bytes <n>\n"
+        << "                            Stop if the output prompt exceeds <n> bytes\n"
+        << "      --timeout <ms>        Stop if compilation takes longer than <ms> milliseconds\n"
+        << "      --parse-threads <n>   Parse top-level Context blocks on <n> threads (default: 0, automatic)\n"
+        << "                            <n> is reduced to at most 4 threads per CPU core\n"
+        << "      --pipeline            Lex each file on its own thread while it is being parsed\n"
+        << "      --only <section>      Only compile the numbered section, such as 1.3.2, and its contents\n"
+        << "      --exclude <section>   Don't compile the numbered section or its contents\n"
+        << "  -MD                       Write a make dependency file listing every file read\n"
+        << "  -MF <file>                Write the dependency file to <file> (default: output file with .d suffix)\n"
+        << "  -MP                       Add a phony target for each dependency other than the input file\n"
+        << "  -MT <target>              Set the target of the dependency rule (default: output file)\n"
         << std::endl;
 }
 
-void simplifyText(ASTNode& node) {
-    size_t i = 0;
-    bool inFormatedSection = false;
+int main(int argc, char* argv[]) {
+    std::string outputFile;
+    bool debug = false;
+    std::string format = "text";
+    bool jsonSections = false;
+    bool writeDependencies = false;
+    std::string dependencyFile;
+    std::string dependencyTarget;
+    bool phonyTargets = false;
+    bool sizeReport = false;
+    auto minifyMode = MinifyMode::NONE;
+    CompileLimits limits;
+    size_t timeoutMs = 0;
+    size_t parseThreads = 0;
+    size_t maxParseThreads = std::max(std::thread::hardware_concurrency(), 1u) * MAX_PARSE_THREADS_PER_CORE;
+    bool pipelined = false;
+    SectionFilter sectionFilter;
+
+    const char* const short_opts = "ho:df:";
+    const option long_opts[] = {
+        {"help", no_argument, nullptr, 'h'},
+        {"outputFile", required_argument, nullptr, 'o'},
+        {"debug", no_argument, nullptr, 'd'},
+        {"format", required_argument, nullptr, 'f'},
+        {"json-sections", no_argument, nullptr, OPT_JSON_SECTIONS},
+        {"minify-embeds", no_argument, nullptr, OPT_MINIFY_EMBEDS},
+        {"strip-licenses", no_argument, nullptr, OPT_STRIP_LICENSES},
+        {"size-report", no_argument, nullptr, OPT_SIZE_REPORT},
+        {"max-input-bytes", required_argument, nullptr, OPT_MAX_INPUT_BYTES},
+        {"max-file-bytes", required_argument, nullptr, OPT_MAX_FILE_BYTES},
+        {"max-include-depth", required_argument, nullptr, OPT_MAX_INCLUDE_DEPTH},
+        {"max-files", required_argument, nullptr, OPT_MAX_FILES},
+        {"max-output-bytes", required_argument, nullptr, OPT_MAX_OUTPUT_BYTES},
+        {"timeout", required_argument, nullptr, OPT_TIMEOUT},
+        {"parse-threads", required_argument, nullptr, OPT_PARSE_THREADS},
+        {"pipeline", no_argument, nullptr, OPT_PIPELINE},
+        {"only", required_argument, nullptr, OPT_ONLY},
+        {"exclude", required_argument, nullptr, OPT_EXCLUDE},
+        {"MD", no_argument, nullptr, OPT_MD},
+        {"MF", required_argument, nullptr, OPT_MF},
+        {"MP", no_argument, nullptr, OPT_MP},
+        {"MT", required_argument, nullptr, OPT_MT},
+        {nullptr, no_argument, nullptr, 0}
+    };
 
-    while (i < node.childNodes_.size()) {
-        auto& child = node.childNodes_[i];
+    while (true) {
+        // Use getopt_long_only so the dependency options can be given with a single dash, as they are for g++.
+        const auto opt = getopt_long_only(argc, argv, short_opts, long_opts, nullptr);
 
-        // If we have anything other than a text node then simply recurse.
-        if (child->tokenType_ != TokenType::TEXT) {
-            simplifyText(*child);
-            i++;
-            continue;
-        }
+        if (opt == -1) break;
 
-        // If we're not processing a formatted text block then any blank lines we encounter here
-        // can just be eaten!
-        if (!inFormatedSection) {
-            if (child->value_.length() == 0) {
-                node.childNodes_.erase(node.childNodes_.begin() + i);
-                i++;
-                continue;
-            }
-        }
+        switch (opt) {
+        case 'h':
+            printUsage(argv[0]);
+            return 0;
 
-        // We have a text node.  If we don't have a sibling then we can't look to merge anything.
-        if (i == node.childNodes_.size() - 1) {
-            i++;
-            continue;
-        }
+        case 'o':
+            outputFile = optarg;
+            break;
 
-        // Do we have a formatted code delimeter?  If yes then track that.
-        if (child->value_.substr(0, 3) == "```") {
-            inFormatedSection = true;
-        }
+        case 'd':
+            debug = true;
+            break;
 
-        // If our sibling isn't a text node we can't merge it.
-        auto& sibling = node.childNodes_[i + 1];
-        if (sibling->tokenType_ != TokenType::TEXT) {
-            inFormatedSection = false;
-            i++;
-            continue;
-        }
+        case 'f':
+            format = optarg;
+            break;
+
+        case OPT_JSON_SECTIONS:
+            jsonSections = true;
+            break;
+
+        case OPT_MINIFY_EMBEDS:
+            minifyMode = MinifyMode::FULL;
+            break;
 
-        // Is our sibling a formatted code delimeter?
-        if (sibling->value_.substr(0, 3) == "```") {
-            // If we're in a formatted section then this is ending that block.
-            if (inFormatedSection) {
-                child->value_ += "\n" + sibling->value_;
-                node.childNodes_.erase(node.childNodes_.begin() + i + 1);
-                i += 2;
-                inFormatedSection = false;
-                continue;
+        case OPT_STRIP_LICENSES:
+            // Full minification already strips every comment, including licenses.
+            if (minifyMode == MinifyMode::NONE) {
+                minifyMode = MinifyMode::LICENSE;
             }
 
-            // We're going to start a new formatted block.
-            i++;
-            continue;
-        }
+            break;
 
-        // If we're in a formatted text section then apply a newline and merge these two elements.
-        if (inFormatedSection) {
-            child->value_ += "\n" + sibling->value_;
-            node.childNodes_.erase(node.childNodes_.begin() + i + 1);
-            continue;
-        }
+        case OPT_SIZE_REPORT:
+            sizeReport = true;
+            break;
 
-        // If our next text is an empty line then this indicates the end of a paragraph.
-        if (sibling->value_.length() == 0) {
-            node.childNodes_.erase(node.childNodes_.begin() + i + 1);
-            i++;
-            continue;
-        }
+        case OPT_MAX_INPUT_BYTES:
+            if (!parseLimit("--max-input-bytes", optarg, limits.maxInputBytes_)) return 1;
+            break;
 
-        child->value_ += " " + sibling->value_;
-        node.childNodes_.erase(node.childNodes_.begin() + i + 1);
-    }
-}
+        case OPT_MAX_FILE_BYTES:
+            if (!parseLimit("--max-file-bytes", optarg, limits.maxFileBytes_)) return 1;
+            break;
 
-void recurse(const ASTNode& node, std::string section, std::ostream& out) {
-    switch (node.tokenType_) {
-    case TokenType::TEXT:
-        out << node.value_ << std::endl << std::endl;
-        return;
+        case OPT_MAX_INCLUDE_DEPTH:
+            if (!parseLimit("--max-include-depth", optarg, limits.maxIncludeDepth_)) return 1;
+            break;
 
-    case TokenType::ACTION:
-    case TokenType::CONTEXT:
-    case TokenType::ROLE:
-        if (node.childNodes_.size()) {
-            const auto& childToken = node.childNodes_[0];
-            if (childToken->tokenType_ == TokenType::KEYWORD_TEXT) {
-                out << section << " " << childToken->value_ << std::endl << std::endl;
-                break;
-            }
-        }
+        case OPT_MAX_FILES:
+            if (!parseLimit("--max-files", optarg, limits.maxFiles_)) return 1;
+            break;
 
-        out << section << std::endl << std::endl;
-        break;
+        case OPT_MAX_OUTPUT_BYTES:
+            if (!parseLimit("--max-output-bytes", optarg, limits.maxOutputBytes_)) return 1;
+            break;
 
-    default:
-        break;
-    }
+        case OPT_TIMEOUT:
+            if (!parseLimit("--timeout", optarg, timeoutMs)) return 1;
+            limits.timeLimit_ = std::chrono::milliseconds(timeoutMs);
+            break;
 
-    int index = 0;
-    for (const auto& child : node.childNodes_) {
-        if (child->tokenType_ == TokenType::CONTEXT ||
-                child->tokenType_ == TokenType::ROLE) {
-            index++;
-        }
+        case OPT_PARSE_THREADS:
+            if (!parseLimit("--parse-threads", optarg, parseThreads)) return 1;
+            if (parseThreads > MAX_PARSE_THREADS) {
+                std::cerr << "Error: --parse-threads can't be more than " << MAX_PARSE_THREADS << ".\n";
+                return 1;
+            }
 
-        recurse(*child, section + "." + std::to_string(index), out);
-    }
-}
+            parseThreads = std::min(parseThreads, maxParseThreads);
+            break;
 
-int main(int argc, char* argv[]) {
-    std::string outputFile;
-    bool debug = false;
+        case OPT_PIPELINE:
+            pipelined = true;
+            break;
 
-    const char* const short_opts = "ho:d";
-    const option long_opts[] = {
-        {"help", no_argument, nullptr, 'h'},
-        {"outputFile", required_argument, nullptr, 'o'},
-        {"debug", no_argument, nullptr, 'd'},
-        {nullptr, no_argument, nullptr, 0}
-    };
+        case OPT_ONLY:
+            if (!sectionFilter.addOnly(optarg)) {
+                std::cerr << "Error: Invalid section number " << optarg << ".\n";
+                return 1;
+            }
 
-    while (true) {
-        const auto opt = getopt_long(argc, argv, short_opts, long_opts, nullptr);
+            break;
 
-        if (opt == -1) break;
+        case OPT_EXCLUDE:
+            if (!sectionFilter.addExclude(optarg)) {
+                std::cerr << "Error: Invalid section number " << optarg << ".\n";
+                return 1;
+            }
 
-        switch (opt) {
-        case 'h':
-            printUsage(argv[0]);
-            return 0;
+            break;
 
-        case 'o':
-            outputFile = optarg;
+        case OPT_MD:
+            writeDependencies = true;
             break;
 
-        case 'd':
-            debug = true;
+        case OPT_MF:
+            dependencyFile = optarg;
+            break;
+
+        case OPT_MP:
+            phonyTargets = true;
+            break;
+
+        case OPT_MT:
+            dependencyTarget = optarg;
             break;
 
         case '?':
@@ -176,6 +275,34 @@ int main(int argc, char* argv[]) {
 
     std::string filePath = argv[optind];
 
+    if (format != "text" && format != "json" && format != "jsonl") {
+        std::cerr << "Error: Unknown output format " << format << ".\n";
+        printUsage(argv[0]);
+        return 1;
+    }
+
+    if (jsonSections && format != "json") {
+        std::cerr << "Error: --json-sections requires --format json.\n";
+        printUsage(argv[0]);
+        return 1;
+    }
+
+    if (writeDependencies) {
+        if (dependencyTarget.empty()) {
+            dependencyTarget = outputFile;
+        }
+
+        if (dependencyFile.empty() && !outputFile.empty()) {
+            dependencyFile = std::filesystem::path(outputFile).replace_extension(".d").string();
+        }
+
+        if (dependencyTarget.empty() || dependencyFile.empty()) {
+            std::cerr << "Error: -MD requires an output file, or both -MF and -MT.\n";
+            printUsage(argv[0]);
+            return 1;
+        }
+    }
+
     if (debug) {
         std::cerr << "Debug mode is ON\n";
     }
@@ -193,8 +320,23 @@ int main(int argc, char* argv[]) {
         outStream = &outFile;
     }
 
+    limits.startClock();
+
     Parser parser;
-    auto res = parser.parse(filePath);
+    parser.setMinifyMode(minifyMode);
+    parser.setLimits(limits);
+    parser.setParseThreads(static_cast<unsigned>(parseThreads));
+    parser.setPipelined(pipelined);
+    parser.setSectionFilter(sectionFilter);
+
+    bool res;
+    try {
+        res = parser.parse(filePath);
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << ".\n";
+        removeOutputFile(outFile, outputFile);
+        return 1;
+    }
 
     if (!res) {
         std::vector<std::string> errorMessages = parser.getSyntaxErrors();
@@ -207,8 +349,51 @@ int main(int argc, char* argv[]) {
     }
 
     auto syntaxTree = parser.getSyntaxTree();
-    simplifyText(*syntaxTree);
-    recurse(*syntaxTree, "1", *outStream);
+    try {
+        simplifyText(*syntaxTree, &limits);
+    } catch (const LimitExceededError& e) {
+        std::cerr << "Error: " << e.what() << ".\n";
+        removeOutputFile(outFile, outputFile);
+        return 1;
+    }
+
+    std::unique_ptr<Emitter> emitter;
+    if (format == "text") {
+        emitter = std::make_unique<Emitter>(*outStream);
+    } else {
+        auto jsonFormat = (format == "jsonl") ? JsonFormat::CHAT : JsonFormat::PROMPT;
+        emitter = std::make_unique<JsonEmitter>(*outStream, jsonFormat, jsonSections);
+    }
+
+    SizeReport report;
+    if (sizeReport) {
+        emitter->setSizeReport(&report);
+    }
+
+    emitter->setLimits(&limits);
+    emitter->setSectionFilter(&sectionFilter);
+
+    try {
+        emitter->emit(*syntaxTree);
+    } catch (const LimitExceededError& e) {
+        std::cerr << "Error: " << e.what() << ".\n";
+        removeOutputFile(outFile, outputFile);
+        return 1;
+    }
+
+    if (sizeReport) {
+        report.print(std::cerr);
+    }
+
+    if (writeDependencies) {
+        std::ofstream depFile(dependencyFile);
+        if (!depFile) {
+            std::cerr << "Error: Could not open dependency file " << dependencyFile << " for writing.\n";
+            return 1;
+        }
+
+        writeDependencyFile(depFile, dependencyTarget, parser.getDependencies(), phonyTargets);
+    }
 
     return 0;
 }
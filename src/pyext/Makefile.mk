@@ -0,0 +1,2 @@
+PYEXT_SRCS += \
+	src/pyext/m6rc_native.cpp
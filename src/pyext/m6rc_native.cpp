@@ -0,0 +1,206 @@
+#define PY_SSIZE_T_CLEAN
+#include <Python.h>
+
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <memory>
+#include <stdexcept>
+
+#include "m6rc/Parser.hpp"
+#include "m6rc/Simplify.hpp"
+#include "m6rc/Emitter.hpp"
+#include "m6rc/JsonEmitter.hpp"
+
+// Convert a Python str or bytes object into a std::string.  Returns false with a Python exception set if
+// the object is neither.
+static auto toString(PyObject* obj, std::string& out) -> bool {
+    if (PyUnicode_Check(obj)) {
+        Py_ssize_t size;
+        const char* data = PyUnicode_AsUTF8AndSize(obj, &size);
+        if (!data) {
+            return false;
+        }
+
+        out.assign(data, size);
+        return true;
+    }
+
+    if (PyBytes_Check(obj)) {
+        out.assign(PyBytes_AS_STRING(obj), PyBytes_GET_SIZE(obj));
+        return true;
+    }
+
+    PyErr_SetString(PyExc_TypeError, "expected str or bytes");
+    return false;
+}
+
+// Runs the full compile pipeline.  This must not touch any Python objects as it runs without the GIL.
+static auto compileToString(const std::string& path, const std::map<std::string, std::string>& buffers,
+        const std::string& format, bool jsonSections, CompileLimits limits, std::string& output,
+        std::vector<std::string>& diagnostics) -> bool {
+    try {
+        limits.startClock();
+
+        Parser parser(buffers);
+        parser.setLimits(limits);
+        if (!parser.parse(path)) {
+            diagnostics = parser.getSyntaxErrors();
+            return false;
+        }
+
+        auto syntaxTree = parser.getSyntaxTree();
+        simplifyText(*syntaxTree, &limits);
+
+        std::ostringstream out;
+        std::unique_ptr<Emitter> emitter;
+        if (format == "text") {
+            emitter = std::make_unique<Emitter>(out);
+        } else {
+            auto jsonFormat = (format == "jsonl") ? JsonFormat::CHAT : JsonFormat::PROMPT;
+            emitter = std::make_unique<JsonEmitter>(out, jsonFormat, jsonSections);
+        }
+
+        emitter->setLimits(&limits);
+        emitter->emit(*syntaxTree);
+        output = out.str();
+        return true;
+    } catch (const std::exception& e) {
+        diagnostics.push_back(e.what());
+        return false;
+    }
+}
+
+static auto m6rcCompile(PyObject* self, PyObject* args, PyObject* kwargs) -> PyObject* {
+    static const char* keywords[] = {
+        "path", "buffers", "format", "json_sections", "max_input_bytes", "max_file_bytes", "max_include_depth",
+        "max_files", "max_output_bytes", "timeout_ms", nullptr
+    };
+    PyObject* pathObj = nullptr;
+    PyObject* buffersObj = Py_None;
+    const char* formatArg = "text";
+    int jsonSections = 0;
+    Py_ssize_t limitArgs[6] = {0, 0, 0, 0, 0, 0};
+
+    if (!PyArg_ParseTupleAndKeywords(args, kwargs, "O&|Ospnnnnnn", const_cast<char**>(keywords),
+            PyUnicode_FSConverter, &pathObj, &buffersObj, &formatArg, &jsonSections,
+            &limitArgs[0], &limitArgs[1], &limitArgs[2], &limitArgs[3], &limitArgs[4], &limitArgs[5])) {
+        return nullptr;
+    }
+
+    std::string path(PyBytes_AS_STRING(pathObj), PyBytes_GET_SIZE(pathObj));
+    Py_DECREF(pathObj);
+
+    std::string format = formatArg;
+    if (format != "text" && format != "json" && format != "jsonl") {
+        PyErr_Format(PyExc_ValueError, "unknown output format '%s'", formatArg);
+        return nullptr;
+    }
+
+    if (jsonSections && format != "json") {
+        PyErr_SetString(PyExc_ValueError, "json_sections requires format 'json'");
+        return nullptr;
+    }
+
+    for (auto limit : limitArgs) {
+        if (limit < 0) {
+            PyErr_SetString(PyExc_ValueError, "limits must be non-negative");
+            return nullptr;
+        }
+    }
+
+    CompileLimits limits;
+    limits.maxInputBytes_ = limitArgs[0];
+    limits.maxFileBytes_ = limitArgs[1];
+    limits.maxIncludeDepth_ = limitArgs[2];
+    limits.maxFiles_ = limitArgs[3];
+    limits.maxOutputBytes_ = limitArgs[4];
+    limits.timeLimit_ = std::chrono::milliseconds(limitArgs[5]);
+
+    // Copy any in-memory buffers before we release the GIL.
+    std::map<std::string, std::string> buffers;
+    if (buffersObj != Py_None) {
+        if (!PyDict_Check(buffersObj)) {
+            PyErr_SetString(PyExc_TypeError, "buffers must be a dict mapping file names to contents");
+            return nullptr;
+        }
+
+        PyObject* key;
+        PyObject* value;
+        Py_ssize_t pos = 0;
+        while (PyDict_Next(buffersObj, &pos, &key, &value)) {
+            PyObject* keyBytes;
+            if (!PyUnicode_FSConverter(key, &keyBytes)) {
+                return nullptr;
+            }
+
+            std::string filename(PyBytes_AS_STRING(keyBytes), PyBytes_GET_SIZE(keyBytes));
+            Py_DECREF(keyBytes);
+
+            if (!toString(value, buffers[filename])) {
+                return nullptr;
+            }
+        }
+    }
+
+    std::string output;
+    std::vector<std::string> diagnostics;
+    bool success;
+
+    Py_BEGIN_ALLOW_THREADS
+    success = compileToString(path, buffers, format, jsonSections != 0, limits, output, diagnostics);
+    Py_END_ALLOW_THREADS
+
+    PyObject* diagnosticsList = PyList_New(0);
+    if (!diagnosticsList) {
+        return nullptr;
+    }
+
+    for (const auto& diagnostic : diagnostics) {
+        PyObject* str = PyUnicode_DecodeUTF8(diagnostic.data(), diagnostic.size(), "replace");
+        if (!str || PyList_Append(diagnosticsList, str) < 0) {
+            Py_XDECREF(str);
+            Py_DECREF(diagnosticsList);
+            return nullptr;
+        }
+
+        Py_DECREF(str);
+    }
+
+    if (!success) {
+        return Py_BuildValue("(ON)", Py_None, diagnosticsList);
+    }
+
+    PyObject* outputStr = PyUnicode_DecodeUTF8(output.data(), output.size(), "replace");
+    if (!outputStr) {
+        Py_DECREF(diagnosticsList);
+        return nullptr;
+    }
+
+    return Py_BuildValue("(NN)", outputStr, diagnosticsList);
+}
+
+static PyMethodDef m6rcMethods[] = {
+    {"compile", reinterpret_cast<PyCFunction>(reinterpret_cast<void (*)(void)>(m6rcCompile)),
+        METH_VARARGS | METH_KEYWORDS,
+        "compile(path, buffers=None, format='text', json_sections=False, max_input_bytes=0, max_file_bytes=0,\n"
+        "        max_include_depth=0, max_files=0, max_output_bytes=0, timeout_ms=0) -> (output, diagnostics)\n\n"
+        "Compile the Metaphor file at path.  buffers may map file names to str or bytes contents that are used\n"
+        "instead of reading those files.  The max_* and timeout_ms arguments limit the resources a compilation\n"
+        "may use (0 means no limit).  output is None if compilation failed.  The GIL is released while\n"
+        "compiling, so prompts can be compiled in parallel from a thread pool."},
+    {nullptr, nullptr, 0, nullptr}
+};
+
+static struct PyModuleDef m6rcModule = {
+    PyModuleDef_HEAD_INIT,
+    "m6rc_native",
+    "Native Metaphor compiler built from the m6rc C++ sources.",
+    -1,
+    m6rcMethods
+};
+
+PyMODINIT_FUNC PyInit_m6rc_native(void) {
+    return PyModule_Create(&m6rcModule);
+}
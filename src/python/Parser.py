@@ -19,7 +19,6 @@ class Parser:
         self.syntax_tree = None
         self.parse_errors = []
         self.lexers = []
-        self.previously_seen_files = set()
 
     def parse(self, filename):
         """
@@ -90,13 +89,12 @@ class Parser:
         return self.parse_errors
 
     def check_file_not_loaded(self, filename):
-        """Check we have not already loaded a file."""
+        """Check a file is not already being processed, which would mean it is including itself."""
         canonical_filename = os.path.realpath(filename)
-        if canonical_filename in self.previously_seen_files:
+        active_files = {os.path.realpath(lexer.filename) for lexer in self.lexers}
+        if canonical_filename in active_files:
             raise FileAlreadyUsedError(filename)
 
-        self.previously_seen_files.add(canonical_filename)
-
     def parse_action(self, token):
         """Parse an action block and construct its AST node."""
         action_node = ASTNode(token)
@@ -102,12 +102,40 @@ def recurse(node, section, out):
         recurse(child, f"{section}.{index}", out)
 
 
+def compile_native(input_file, output_stream, output_file):
+    """
+    Compile using the native extension module built from the C++ compiler sources.
+
+    Args:
+        input_file (str): The Metaphor file to compile.
+        output_stream (file): The output stream to write to.
+        output_file (str): The output file name, if output is not going to stdout.
+    """
+    # Import here so the pure Python implementation works without the extension being built.
+    import m6rc_native  # pylint: disable=import-outside-toplevel
+
+    output, diagnostics = m6rc_native.compile(input_file)
+    if output is None:
+        for error in diagnostics:
+            print(f"----------------\n{error}")
+
+        print("----------------\n")
+        return -1
+
+    output_stream.write(output)
+    if output_file:
+        output_stream.close()
+
+    return 0
+
+
 def main():
     """Main entry point for the program."""
     parser = argparse.ArgumentParser()
     parser.add_argument("input_file", help="Input file to parse")
     parser.add_argument("-o", "--outputFile", help="Output file")
     parser.add_argument("-d", "--debug", action="store_true", help="Enable debug mode")
+    parser.add_argument("--native", action="store_true", help="Compile using the native m6rc_native extension")
 
     args = parser.parse_args()
 
@@ -130,6 +158,9 @@ def main():
             print(f"Error: Could not open output file {output_file}: {e}")
             return 1
 
+    if args.native:
+        return compile_native(input_file, output_stream, output_file)
+
     parser = Parser()
     if not parser.parse(input_file):
         for error in parser.get_syntax_errors():
@@ -0,0 +1,73 @@
+"""Generates large, deterministic Metaphor inputs used by the performance tests."""
+
+import sys
+import argparse
+from pathlib import Path
+
+def write_file(path, lines):
+    """Writes a list of lines to a file, creating any parent directories."""
+    path.parent.mkdir(parents=True, exist_ok=True)
+    with open(path, 'w') as file:
+        file.write("\n".join(lines))
+        file.write("\n")
+
+def generate_many_contexts(out_dir, count):
+    """Generates a single root file with a large number of top-level Context blocks."""
+    lines = ["Action: Performance test with many contexts", "    Check how quickly we handle large root files.", ""]
+    for i in range(count):
+        lines.append(f"    Context: Context block {i}")
+        lines.append(f"        This is the text for context block {i}.  It spans a couple of lines so that the")
+        lines.append("        text simplification pass has some merging to do.")
+        lines.append("")
+        lines.append("        Context:")
+        lines.append(f"            A nested context inside block {i}.")
+        lines.append("")
+
+    write_file(out_dir / "many-contexts.m6r", lines)
+
+def generate_large_embed(out_dir, line_count):
+    """Generates a root file that embeds one very large source file."""
+    source = []
+    for i in range(line_count):
+        source.append(f"int function_{i}(int x) {{ return x * {i % 97} + \"{i}\"[0]; }}  // comment {i}")
+
+    write_file(out_dir / "large-embed" / "source.cpp", source)
+    write_file(out_dir / "large-embed.m6r", [
+        "Action: Performance test with a large embed",
+        "    Context: Source",
+        f"        Embed: {out_dir / 'large-embed' / 'source.cpp'}"
+    ])
+
+def generate_many_includes(out_dir, count):
+    """Generates a root file that includes a large number of small Metaphor files."""
+    lines = ["Action: Performance test with many includes"]
+    for i in range(count):
+        include = out_dir / "many-includes" / f"include-{i}.m6r"
+        write_file(include, [
+            f"Context: Included block {i}",
+            f"    Text from included file {i}.",
+            "",
+            "    Context:",
+            "        A nested context in an included file."
+        ])
+        lines.append(f"    Include: {include}")
+
+    write_file(out_dir / "many-includes.m6r", lines)
+
+def main():
+    """Main entry point for the performance input generator."""
+    parser = argparse.ArgumentParser(description="Generate performance test inputs for the metaphor compiler.")
+    parser.add_argument("output_dir", help="Directory in which to write the generated files.")
+    args = parser.parse_args()
+
+    out_dir = Path(args.output_dir)
+    try:
+        generate_many_contexts(out_dir, 20000)
+        generate_large_embed(out_dir, 20000)
+        generate_many_includes(out_dir, 2000)
+    except OSError as e:
+        print(f"Failed to generate performance inputs: {e}")
+        sys.exit(1)
+
+if __name__ == "__main__":
+    main()
@@ -2,12 +2,23 @@ import json
 import subprocess
 import os
 import sys
+import time
 import argparse
+import hashlib
+import tempfile
+import threading
+import statistics
 import concurrent.futures
 from pathlib import Path
 from multiprocessing import cpu_count
 
 DEFAULT_TIMEOUT = 5000  # milliseconds
+DEFAULT_REPEAT = 1
+DEFAULT_TOLERANCE = 20  # percent
+MIN_TIME_SLACK = 50  # milliseconds
+CALIBRATION_KEY = "calibration"
+CALIBRATION_BYTES = 64 * 1024 * 1024
+CALIBRATION_REPEAT = 5
 
 def parse_config_file(config_file):
     """Parses the configuration file and validates each test configuration."""
@@ -27,7 +38,7 @@ def validate_test_config(test, line_number):
     valid_types = {"positive", "negative"}
 
     for key in test:
-        if key not in {"command", "type", "expected", "timeout"}:
+        if key not in {"command", "type", "expected", "timeout", "repeat", "max_time_ms", "max_rss_kb"}:
             print(f"Invalid key '{key}' found in the configuration on line {line_number}.")
             sys.exit(1)
 
@@ -40,55 +51,203 @@ def validate_test_config(test, line_number):
         print(f"Invalid test type '{test['type']}' in configuration on line {line_number}.")
         sys.exit(1)
 
-def run_test(test):
+    for key in ("timeout", "repeat", "max_time_ms", "max_rss_kb"):
+        if key in test and (not isinstance(test[key], (int, float)) or test[key] <= 0):
+            print(f"Invalid value for '{key}' in configuration on line {line_number}: must be a positive number.")
+            sys.exit(1)
+
+def load_baseline(baseline_file):
+    """Loads the performance baseline file, returning an empty baseline if it does not exist yet."""
+    if not Path(baseline_file).is_file():
+        return {}
+
+    with open(baseline_file, 'r') as file:
+        try:
+            return json.load(file)
+        except json.JSONDecodeError as e:
+            print(f"Error parsing the baseline file: {e}")
+            sys.exit(1)
+
+def save_baseline(baseline_file, results, calibration_ms):
+    """Writes the median measurements from a test run as the new performance baseline."""
+    baseline = {CALIBRATION_KEY: {"time_ms": calibration_ms}}
+    for _, command, _, perf in results:
+        if perf is not None:
+            baseline[command] = perf
+
+    with open(baseline_file, 'w') as file:
+        json.dump(baseline, file, indent=4, sort_keys=True)
+        file.write("\n")
+
+def calibrate():
+    """
+    Times a fixed CPU-bound workload, returning the median wall time in ms.
+
+    Baseline times are only meaningful on the machine that recorded them, so the ratio between this time and
+    the one saved with the baseline is used to scale the baseline to the machine running the tests.
+    """
+    data = bytes(CALIBRATION_BYTES)
+    times = []
+    for _ in range(CALIBRATION_REPEAT):
+        start = time.perf_counter()
+        hashlib.sha256(data).digest()
+        times.append((time.perf_counter() - start) * 1000)
+
+    return round(statistics.median(times), 1)
+
+def scale_baseline(baseline, calibration_ms):
+    """Scales the baseline times by how much slower or faster this machine is than the one that recorded them."""
+    if CALIBRATION_KEY not in baseline:
+        return baseline
+
+    scale = calibration_ms / baseline[CALIBRATION_KEY]["time_ms"]
+    scaled = {}
+    for command, perf in baseline.items():
+        if command == CALIBRATION_KEY:
+            continue
+
+        scaled[command] = dict(perf)
+        if "time_ms" in perf:
+            scaled[command]["time_ms"] = round(perf["time_ms"] * scale, 1)
+
+    return scaled
+
+def run_process(command, timeout):
+    """
+    Runs a single test process, returning its exit code, console output, wall time in ms and peak RSS in KB.
+
+    The process is reaped with os.wait4 so we get resource usage for that process alone, even when other
+    tests are running in parallel.  Output goes to a temporary file so the child can never block on a full
+    pipe while we wait for it.  Returns None for the exit code if the process timed out.
+    """
+    with tempfile.TemporaryFile() as output:
+        start = time.perf_counter()
+        process = subprocess.Popen(command, shell=True, stdout=output, stderr=subprocess.STDOUT)
+        timed_out = threading.Event()
+
+        def kill_process():
+            timed_out.set()
+            process.kill()
+
+        timer = threading.Timer(timeout / 1000, kill_process)
+        timer.start()
+        try:
+            _, status, rusage = os.wait4(process.pid, 0)
+        finally:
+            timer.cancel()
+
+        wall_ms = (time.perf_counter() - start) * 1000
+        process.returncode = os.waitstatus_to_exitcode(status)
+
+        # ru_maxrss is reported in bytes on macOS and in KB everywhere else.
+        rss_kb = rusage.ru_maxrss
+        if sys.platform == "darwin":
+            rss_kb //= 1024
+
+        output.seek(0)
+        stdout = output.read().decode('utf-8')
+
+    if timed_out.is_set():
+        return None, stdout, wall_ms, rss_kb
+
+    return process.returncode, stdout, wall_ms, rss_kb
+
+def check_performance(test, perf, baseline, tolerance):
+    """Checks median measurements against the test's budgets and the baseline, returning a list of failures."""
+    failures = []
+    command = test["command"]
+
+    if "max_time_ms" in test and perf["time_ms"] > test["max_time_ms"]:
+        failures.append(f"median time {perf['time_ms']:.1f} ms exceeds budget of {test['max_time_ms']} ms")
+
+    if "max_rss_kb" in test and perf["rss_kb"] > test["max_rss_kb"]:
+        failures.append(f"median peak RSS {perf['rss_kb']} KB exceeds budget of {test['max_rss_kb']} KB")
+
+    if command in baseline:
+        limit = 1 + tolerance / 100
+        for key, units in (("time_ms", "ms"), ("rss_kb", "KB")):
+            if key not in baseline[command]:
+                continue
+
+            # Short runs are dominated by process startup and scheduling noise, so always allow some slack on
+            # time.
+            allowed = baseline[command][key] * limit
+            if key == "time_ms":
+                allowed = max(allowed, baseline[command][key] + MIN_TIME_SLACK)
+
+            if perf[key] > allowed:
+                failures.append(f"median {key} {perf[key]:.1f} {units} exceeds baseline of "
+                                f"{baseline[command][key]:.1f} {units} by more than {tolerance}%")
+
+    return failures
+
+def run_test(test, baseline, tolerance):
     """Executes a single test case and checks for expected outcomes."""
     command = test["command"]
     test_type = test["type"]
     timeout = test.get("timeout", DEFAULT_TIMEOUT)
     expected_file = test.get("expected", None)
+    repeat = test.get("repeat", DEFAULT_REPEAT)
+    measure = repeat > 1 or "max_time_ms" in test or "max_rss_kb" in test or command in baseline
 
     print(f"Start {command}")
     try:
-        process = subprocess.Popen(command, shell=True, stdout=subprocess.PIPE, stderr=subprocess.STDOUT)
-        stdout, _ = process.communicate(timeout=timeout / 1000)
-        exit_code = process.returncode
-        stdout = stdout.decode('utf-8')
-
-        if test_type == "positive" and exit_code != 0:
-            return "FAIL", command, stdout
-
-        if test_type == "negative" and exit_code == 0:
-            return "FAIL", command, stdout
-
-        if expected_file:
-            with open(expected_file, 'r') as file:
-                expected_output = file.read()
-                if stdout != expected_output:
-                    return "FAIL", command, stdout
-
-        return "PASS", command, stdout
-    except subprocess.TimeoutExpired:
-        process.kill()
-        return "FAIL", command, f"Test timed out after {timeout} ms"
+        times = []
+        rss = []
+        for _ in range(repeat):
+            exit_code, stdout, wall_ms, rss_kb = run_process(command, timeout)
+            if exit_code is None:
+                return "FAIL", command, f"Test timed out after {timeout} ms", None
+
+            if test_type == "positive" and exit_code != 0:
+                return "FAIL", command, stdout, None
+
+            if test_type == "negative" and exit_code == 0:
+                return "FAIL", command, stdout, None
+
+            if expected_file:
+                with open(expected_file, 'r') as file:
+                    expected_output = file.read()
+                    if stdout != expected_output:
+                        return "FAIL", command, stdout, None
+
+            times.append(wall_ms)
+            rss.append(rss_kb)
+
+        if not measure:
+            return "PASS", command, stdout, None
+
+        # Compare medians so a single slow run caused by system noise doesn't fail the test.
+        perf = {"time_ms": round(statistics.median(times), 1), "rss_kb": int(statistics.median(rss))}
+        failures = check_performance(test, perf, baseline, tolerance)
+        if failures:
+            return "FAIL", command, "\n".join(failures), perf
+
+        return "PASS", command, stdout, perf
     except Exception as e:
-        return "FAIL", command, str(e)
+        return "FAIL", command, str(e), None
 
-def execute_tests(config, max_parallel_tests):
+def execute_tests(config, max_parallel_tests, baseline, tolerance):
     """Executes all tests in parallel and collects their results."""
     with concurrent.futures.ThreadPoolExecutor(max_workers=max_parallel_tests) as executor:
-        futures = {executor.submit(run_test, test): test for test in config}
+        futures = {executor.submit(run_test, test, baseline, tolerance): test for test in config}
         results = []
 
         for future in concurrent.futures.as_completed(futures):
             result = future.result()
             results.append(result)
-            status, command, _ = result
+            status, command, output, perf = result
             if status == "PASS":
                 # Green text for PASS, red text for FAIL.
                 print(f"\033[92mPASS: {command}\033[0m")
             else:
                 print(f"\033[91mFAIL: {command}\033[0m")
 
+            if perf is not None:
+                print(f"    time: {perf['time_ms']:.1f} ms, peak RSS: {perf['rss_kb']} KB")
+                if status != "PASS":
+                    print(f"    {output}")
+
         return results
 
 def summarize_results(results):
@@ -109,16 +268,36 @@ def main():
     parser = argparse.ArgumentParser(description="Run tests for the metaphor compiler.")
     parser.add_argument("config_file", help="Path to the JSON configuration file.")
     parser.add_argument("--parallel-tests", type=int, default=cpu_count(), help="Maximum number of parallel tests.")
+    parser.add_argument("--baseline", help="Path to a JSON performance baseline file to compare results against.")
+    parser.add_argument("--tolerance", type=float, default=DEFAULT_TOLERANCE,
+                        help="Percentage by which a result may exceed its baseline before the test fails.")
+    parser.add_argument("--update-baseline", action="store_true",
+                        help="Write the measured results to the baseline file instead of comparing against it.")
     args = parser.parse_args()
 
+    if args.update_baseline and not args.baseline:
+        print("--update-baseline requires --baseline.")
+        sys.exit(1)
+
     if not Path(args.config_file).is_file():
         print(f"Configuration file '{args.config_file}' does not exist.")
         sys.exit(1)
 
     config = parse_config_file(args.config_file)
-    results = execute_tests(config, args.parallel_tests)
+    baseline = {}
+    calibration_ms = None
+    if args.baseline:
+        calibration_ms = calibrate()
+        print(f"Calibration: {calibration_ms:.1f} ms")
+        if not args.update_baseline:
+            baseline = scale_baseline(load_baseline(args.baseline), calibration_ms)
+
+    results = execute_tests(config, args.parallel_tests, baseline, args.tolerance)
     all_tests_passed = summarize_results(results)
 
+    if args.update_baseline and all_tests_passed:
+        save_baseline(args.baseline, results, calibration_ms)
+
     sys.exit(0 if all_tests_passed else 1)
 
 if __name__ == "__main__":
@@ -0,0 +1,21 @@
+/*
+ * Copyright (c) 2024 Example Corp.
+ * Licensed under the MIT License.
+ */
+
+#include <iostream>   // for std::cout
+
+
+
+// Print some strings that look like comments.
+int main() {
+    const char* url = "http://example.com/*not-a-comment*/";    
+    char quote = '"';
+    char slash = '/';
+    /* block */ std::cout << url << quote << slash << "\"// still a string" << std::endl;
+    auto raw = R"(a "quoted" /* not a comment */ value)";  // a comment
+    auto delimited = u8R"sep(C:\dir\ )" // still raw)sep";
+    std::cout << raw << delimited << std::endl;
+    /* multi
+       line */ return 0;
+}
@@ -0,0 +1,4 @@
+// Verbatim strings have no backslash escapes.
+var a = @"C:\dir\"; var b = "// not a comment";
+var c = @"say ""hi"" // still a string"; // comment
+var d = $@"{a}\"; /* comment */ var e = @$"{b}\";
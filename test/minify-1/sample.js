@@ -0,0 +1,7 @@
+// Regular expressions can hold comment markers.
+const re = /https?:\/\//.test(url); // real comment
+const classes = [/[/*]/, /\/\*x/g];
+const ratio = total / count / 2; // halved
+if (ok) {
+    return /a\/b/i.exec(s) /* trailing */;
+}
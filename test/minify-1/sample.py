@@ -0,0 +1,15 @@
+#!/usr/bin/env python3
+# Copyright 2024 Example Corp.
+# SPDX-License-Identifier: MIT
+
+"""Docstring with # hash
+
+and a blank line that must stay."""
+
+def main():
+    # Comment line
+    s = "# not a comment"  # trailing comment
+    t = 'it''s'
+
+
+    return s + t
@@ -0,0 +1,5 @@
+#!/bin/sh
+# Heredocs can hold lines that look like comments.
+cat <<END
+# not a comment
+END
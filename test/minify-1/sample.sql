@@ -0,0 +1,4 @@
+-- Schema comment
+SELECT 'it''s -- not a comment', "col" -- comment
+FROM t /* block
+comment */ WHERE x = 1;
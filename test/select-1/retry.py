@@ -0,0 +1,6 @@
+def fetch(client, url, retries=3):
+    for attempt in range(retries):
+        try:
+            return client.get(url)
+        except TimeoutError:
+            pass